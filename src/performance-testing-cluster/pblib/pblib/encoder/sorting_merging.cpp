@@ -7,11 +7,11 @@ using namespace std;
 
 namespace PBLib
 {
-    vector<vector<int32_t> > Sorting::s_auxs;
+    thread_local vector<vector<int32_t> > Sorting::s_auxs;
 
-    map< pair<int32_t,int32_t>, int64_t> Sorting::recursive_sorter_values;
-    map< tuple<int32_t,int32_t,int32_t>, int64_t> Sorting::recursive_sorter_l_values;
-    map< tuple<int32_t,int32_t,int32_t>, int64_t> Sorting::recursive_merger_values;
+    thread_local map< pair<int32_t,int32_t>, int64_t> Sorting::recursive_sorter_values;
+    thread_local map< tuple<int32_t,int32_t,int32_t>, int64_t> Sorting::recursive_sorter_l_values;
+    thread_local map< tuple<int32_t,int32_t,int32_t>, int64_t> Sorting::recursive_merger_values;
 
 
 
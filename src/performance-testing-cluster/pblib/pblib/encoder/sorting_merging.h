@@ -37,11 +37,12 @@ namespace PBLib
     public:
       enum ImplicationDirection {INPUT_TO_OUTPUT, OUTPUT_TO_INPUT, BOTH};
     private:
-      static std::vector<std::vector<int32_t> > s_auxs;
+      // thread local so that separate PB2CNF instances can encode constraints concurrently
+      static thread_local std::vector<std::vector<int32_t> > s_auxs;
 
-      static std::map< std::pair<int32_t,int32_t>, int64_t> recursive_sorter_values;
-      static std::map< std::tuple<int32_t,int32_t,int32_t>, int64_t> recursive_sorter_l_values;
-      static std::map< std::tuple<int32_t,int32_t,int32_t>, int64_t> recursive_merger_values;
+      static thread_local std::map< std::pair<int32_t,int32_t>, int64_t> recursive_sorter_values;
+      static thread_local std::map< std::tuple<int32_t,int32_t,int32_t>, int64_t> recursive_sorter_l_values;
+      static thread_local std::map< std::tuple<int32_t,int32_t,int32_t>, int64_t> recursive_merger_values;
 
       static void counter_sorter(int m, std::vector<int32_t> const & input, ClauseDatabase & formula, AuxVarManager & auxvars, std::vector<int32_t> & output, ImplicationDirection direction);
       static void direct_sorter(int m, std::vector<int32_t> const & input, ClauseDatabase & formula, AuxVarManager & auxvars, std::vector<int32_t> & output, ImplicationDirection direction);
@@ -5,11 +5,11 @@ const Formula _false_ = FormulaClass::newFalse();
 const Formula _true_ = FormulaClass::newTrue();
 const Formula _undef_ = FormulaClass::newUndef();
 
-int32_t FormulaClass::id = 3;
-std::vector<Formula> FormulaClass::nodes;
-std::map<uint64_t, std::vector<Formula>> FormulaClass::formula_cache;
-std::map<uint64_t, std::vector<Formula>>::iterator FormulaClass::it;
-PBConfig FormulaClass::config;
+thread_local int32_t FormulaClass::id = 3;
+thread_local std::vector<Formula> FormulaClass::nodes;
+thread_local std::map<uint64_t, std::vector<Formula>> FormulaClass::formula_cache;
+thread_local std::map<uint64_t, std::vector<Formula>>::iterator FormulaClass::it;
+thread_local PBConfig FormulaClass::config;
 
 Formula FormulaClass::newITE(const Formula& s, const Formula& t, const Formula& f)
 {
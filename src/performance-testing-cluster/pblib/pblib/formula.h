@@ -52,12 +52,13 @@ class FormulaClass
 {
 
 private:
-  static std::map<uint64_t, std::vector<Formula>> formula_cache;
-  static std::map<uint64_t, std::vector<Formula>>::iterator it;
-  static int32_t id;
-  static std::vector<Formula> nodes;
+  // thread local so that separate PB2CNF instances can encode constraints concurrently
+  static thread_local std::map<uint64_t, std::vector<Formula>> formula_cache;
+  static thread_local std::map<uint64_t, std::vector<Formula>>::iterator it;
+  static thread_local int32_t id;
+  static thread_local std::vector<Formula> nodes;
 public:
-  static PBConfig config;
+  static thread_local PBConfig config;
   FormulaClass(int32_t flags, int32_t data, copy_tag) : flags(flags), data(data)
   {
     assert( (flags & 2) != 0); // Do NOT use this ctor for compound formulas! You would copy the id!
@@ -28,6 +28,7 @@ int main(int argc, char* argv[])
 	string project_lib_subfolder;
 	int setup_time;
 	command_line_parameters >> project_lib_subfolder >> project_file_name >> setup_time >> solve_heuristically;
+	parse_optional_parameters(argc, argv, 5);
 
 	ifstream project_lib(project_lib_subfolder + project_file_name);
 
@@ -41,8 +42,86 @@ int main(int argc, char* argv[])
 
 	cout << optimal_solution << '\n';
 
+	if (warm_start_sat && (solve_heuristically || !encode_in_memory)) {
+		throw runtime_error("The warm start needs the SAT solver with the in-memory encoding");
+	}
+	if (warm_start_sat && heuristic_time_limit == 0 && heuristic_iteration_limit == 0 && heuristic_stagnation_limit == 0) {
+		throw runtime_error("The warm start needs a time, iteration or stagnation limit for the heuristic");
+	}
+	if (solve_hybrid && (solve_heuristically || !encode_in_memory)) {
+		throw runtime_error("The hybrid search needs the SAT solver with the in-memory encoding");
+	}
+	if (solve_hybrid && warm_start_sat) {
+		throw runtime_error("The hybrid search already starts the SAT solver from the heuristic, it cannot be combined with the warm start");
+	}
+
+	if (use_lazy_clause_generation && (solve_heuristically || !encode_in_memory)) {
+		throw runtime_error("The lazy clause generation model needs the SAT solver with the in-memory encoding");
+	}
+	if (use_lazy_clause_generation && (warm_start_sat || solve_hybrid)) {
+		throw runtime_error("The lazy clause generation model has no start and process variables to assign the schedules of the heuristic to");
+	}
+	if (use_lazy_clause_generation && lazy_segment_limit > 0 && horizon_heuristic_time_limit > 0) {
+		throw runtime_error("The heuristic may split tasks into more segments than the limit of the lazy clause generation model allows");
+	}
+
 	if (solve_heuristically) {
-		heuristic_solver.solve(project_lib_subfolder, project_file_name, setup_time);
+		heuristic_solver.set_budget(heuristic_time_limit, heuristic_iteration_limit, heuristic_stagnation_limit);
+		if (log_heuristic_improvements) {
+			heuristic_solver.set_improvement_callback([](int makespan, double elapsed_seconds) { cerr << "heuristic improvement: " << makespan << ' ' << elapsed_seconds << '\n'; });
+		}
+		int heuristic_makespan = heuristic_solver.solve(project_lib_subfolder, project_file_name, setup_time);
+		cout << "heuristic makespan: " << heuristic_makespan << '\n';
+		return 0;
+	}
+
+	if (horizon_heuristic_time_limit > 0) {
+		tighten_encoding_horizon(project_lib_subfolder, project_file_name, setup_time);
+	}
+
+	if (solve_hybrid) {
+		// The heuristic runs until the SAT solver is done, its budget only ends it earlier
+		Hybrid_solution_exchange solution_exchange(heuristic_solver, sat_encoder);
+		heuristic_solver.set_budget(heuristic_time_limit, heuristic_iteration_limit, heuristic_stagnation_limit);
+		if (log_heuristic_improvements) {
+			heuristic_solver.set_improvement_callback([](int makespan, double elapsed_seconds) { cerr << "heuristic improvement: " << makespan << ' ' << elapsed_seconds << '\n'; });
+		}
+		heuristic_solver.set_solution_callback([&solution_exchange](Heuristic_Solver::Solution& solution) { solution_exchange.submit_heuristic_solution(solution); });
+		thread heuristic_thread(&Heuristic_Solver::solve, &heuristic_solver, project_lib_subfolder, project_file_name, setup_time);
+
+		bool optimum_found;
+		int SAT_makespan = solve([&](Pumpkin::ConstraintOptimisationSolver& solver) {
+			sat_encoder.encode(project_lib_subfolder, project_file_name, setup_time, solver);
+			solver.SetWarmStartAssignment(solution_exchange.TakeExternalSolution());
+			solver.SetSolutionExchange(&solution_exchange);
+		}, optimum_found);
+
+		heuristic_solver.stop();
+		heuristic_thread.join();
+		cout << "SAT makespan: " << SAT_makespan << '\n';
+	}
+	else if (encode_in_memory) {
+		Heuristic_Solver::Solution warm_start_solution;
+		if (warm_start_sat) {
+			heuristic_solver.set_budget(heuristic_time_limit, heuristic_iteration_limit, heuristic_stagnation_limit);
+			heuristic_solver.solve(project_lib_subfolder, project_file_name, setup_time);
+			warm_start_solution = heuristic_solver.get_best_solution();
+			sat_encoder.set_heuristic_upper_bound(warm_start_solution.makespan);
+		}
+
+		bool optimum_found;
+		int SAT_makespan = solve([&](Pumpkin::ConstraintOptimisationSolver& solver) {
+			if (use_lazy_clause_generation) {
+				sat_encoder.encode_with_propagators(project_lib_subfolder, project_file_name, setup_time, solver);
+			}
+			else {
+				sat_encoder.encode(project_lib_subfolder, project_file_name, setup_time, solver);
+			}
+			if (warm_start_sat) {
+				solver.SetWarmStartAssignment(sat_encoder.create_warm_start_assignment(warm_start_solution));
+			}
+		}, optimum_found);
+		cout << "SAT makespan: " << SAT_makespan << '\n';
 	}
 	else {
 		sat_encoder.encode(project_lib_subfolder, project_file_name, setup_time);
@@ -58,19 +137,440 @@ int main(int argc, char* argv[])
 	return 0;
 }
 
+static void parse_optional_parameters(int argc, char* argv[], int first_optional_index)
+{
+	for (int i = first_optional_index; i < argc; i += 2)
+	{
+		string parameter_name = argv[i];
+		if (i + 1 >= argc) {
+			throw runtime_error("No value given for parameter " + parameter_name);
+		}
+		string parameter_value = argv[i + 1];
+
+		if (parameter_name == "-in-memory") {
+			encode_in_memory = stoi(parameter_value) != 0;
+		}
+		else if (parameter_name == "-encoding-threads") {
+			encoding_threads = max(1, stoi(parameter_value));
+		}
+		else if (parameter_name == "-resource-cache") {
+			use_resource_encoding_cache = stoi(parameter_value) != 0;
+		}
+		else if (parameter_name == "-heuristic-threads") {
+			heuristic_threads = max(1, stoi(parameter_value));
+		}
+		else if (parameter_name == "-heuristic-restart") {
+			heuristic_restart_interval = max(1, stoi(parameter_value));
+		}
+		else if (parameter_name == "-heuristic-time-limit") {
+			heuristic_time_limit = max(0.0, stod(parameter_value));
+		}
+		else if (parameter_name == "-heuristic-iterations") {
+			heuristic_iteration_limit = max(0LL, stoll(parameter_value));
+		}
+		else if (parameter_name == "-heuristic-stagnation") {
+			heuristic_stagnation_limit = max(0LL, stoll(parameter_value));
+		}
+		else if (parameter_name == "-heuristic-log-improvements") {
+			log_heuristic_improvements = stoi(parameter_value) != 0;
+		}
+		else if (parameter_name == "-warm-start") {
+			warm_start_sat = stoi(parameter_value) != 0;
+		}
+		else if (parameter_name == "-hybrid") {
+			solve_hybrid = stoi(parameter_value) != 0;
+		}
+		else if (parameter_name == "-horizon-heuristic-time") {
+			horizon_heuristic_time_limit = max(0.0, stod(parameter_value));
+		}
+		else if (parameter_name == "-energetic-windows") {
+			use_energetic_windows = stoi(parameter_value) != 0;
+		}
+		else if (parameter_name == "-prune-segments") {
+			use_segment_pruning = stoi(parameter_value) != 0;
+		}
+		else if (parameter_name == "-process-aggregates") {
+			use_process_aggregates = stoi(parameter_value) != 0;
+		}
+		else if (parameter_name == "-resource-event-points") {
+			use_resource_event_points = stoi(parameter_value) != 0;
+		}
+		else if (parameter_name == "-order-encoding") {
+			use_order_encoding = stoi(parameter_value) != 0;
+		}
+		else if (parameter_name == "-lazy-clause-generation") {
+			use_lazy_clause_generation = stoi(parameter_value) != 0;
+		}
+		else if (parameter_name == "-lazy-segments") {
+			lazy_segment_limit = max(0, stoi(parameter_value));
+		}
+		// The strategies of the cumulative propagators are parameters of the solver, their values are checked when it is created
+		else if (parameter_name == "-cumulative-task-ordering" || parameter_name == "-cumulative-incremental" || parameter_name == "-cumulative-lifting"
+			|| parameter_name == "-cumulative-energetic-reasoning") {
+			set_solver_parameter(parameter_name.substr(1), parameter_value);
+		}
+		else {
+			throw runtime_error("Unknown parameter " + parameter_name);
+		}
+	}
+}
+
+// Runs a separate heuristic within the time limit and encodes against its makespan, which is usually far below the greedy upper bound
+static void tighten_encoding_horizon(string project_lib_folder, string project_lib_file, int setup_time)
+{
+	Heuristic_Solver horizon_solver;
+	horizon_solver.set_budget(horizon_heuristic_time_limit, 0, 0);
+	sat_encoder.set_heuristic_upper_bound(horizon_solver.solve(project_lib_folder, project_lib_file, setup_time));
+}
+
+int Clause_sink::get_clause_count()
+{
+	return clause_count;
+}
+
+Wcnf_file_sink::Wcnf_file_sink(string file_name, int64_t hard_clause_weight) : buffer(buffer_size), hard_clause_weight(hard_clause_weight), hard_clause_weight_text(to_string(hard_clause_weight) + ' ')
+{
+	cnf_file = fopen(file_name.c_str(), "wb");
+	if (cnf_file == NULL) {
+		throw runtime_error("Could not open cnf file");
+	}
+	// The counts are not known yet, the placeholder is overwritten in close()
+	write_header();
+}
+
+Wcnf_file_sink::~Wcnf_file_sink()
+{
+	close();
+}
+
+void Wcnf_file_sink::set_variable_count(int32_t variable_count)
+{
+	this->variable_count = variable_count;
+}
+
+void Wcnf_file_sink::add_hard_clause(vector<int32_t>& clause)
+{
+	reserve(clause.size());
+	memcpy(buffer.data() + buffer_used, hard_clause_weight_text.data(), hard_clause_weight_text.size());
+	buffer_used += hard_clause_weight_text.size();
+	write_literals(clause);
+}
+
+void Wcnf_file_sink::add_soft_clause(vector<int32_t>& clause, int64_t weight)
+{
+	reserve(clause.size());
+	write_integer(weight);
+	buffer[buffer_used++] = ' ';
+	write_literals(clause);
+}
+
+// Makes sure the next clause fits in the buffer, a weight takes at most 21 characters and every literal at most 12
+void Wcnf_file_sink::reserve(size_t clause_size)
+{
+	size_t required_size = 21 + 12 * (clause_size + 1);
+	if (buffer_used + required_size > buffer.size()) {
+		flush();
+	}
+	if (required_size > buffer.size()) {
+		buffer.resize(required_size);
+	}
+}
+
+void Wcnf_file_sink::write_literals(vector<int32_t>& clause)
+{
+	for (int32_t literal : clause)
+	{
+		write_integer(literal);
+		buffer[buffer_used++] = ' ';
+	}
+	buffer[buffer_used++] = '0';
+	buffer[buffer_used++] = '\n';
+	clause_count++;
+}
+
+void Wcnf_file_sink::write_integer(int64_t value)
+{
+	char digits[20];
+	int digit_count = 0;
+	uint64_t magnitude = value < 0 ? 0 - (uint64_t)value : (uint64_t)value;
+	if (value < 0) {
+		buffer[buffer_used++] = '-';
+	}
+	do {
+		digits[digit_count++] = '0' + (char)(magnitude % 10);
+		magnitude /= 10;
+	} while (magnitude > 0);
+	while (digit_count > 0) {
+		buffer[buffer_used++] = digits[--digit_count];
+	}
+}
+
+void Wcnf_file_sink::write_header()
+{
+	// p FORMAT VARIABLES CLAUSES TOP, the counts are padded so the header has the same length before and after back-patching
+	string header = string("p ") + cnf_file_type + ' ';
+	string variable_count_text = to_string(variable_count);
+	string clause_count_text = to_string(clause_count);
+	header += variable_count_text + string(header_count_width - variable_count_text.size(), ' ') + ' ';
+	header += clause_count_text + string(header_count_width - clause_count_text.size(), ' ') + ' ';
+	header += to_string(hard_clause_weight) + '\n';
+	fwrite(header.data(), 1, header.size(), cnf_file);
+}
+
+void Wcnf_file_sink::flush()
+{
+	fwrite(buffer.data(), 1, buffer_used, cnf_file);
+	buffer_used = 0;
+}
+
+void Wcnf_file_sink::close()
+{
+	if (cnf_file == NULL) {
+		return;
+	}
+	flush();
+	fseek(cnf_file, 0, SEEK_SET);
+	write_header();
+	fclose(cnf_file);
+	cnf_file = NULL;
+}
+
+Solver_clause_sink::Solver_clause_sink(Pumpkin::ConstraintOptimisationSolver& solver) : solver(solver)
+{
+}
+
+void Solver_clause_sink::set_variable_count(int32_t variable_count)
+{
+	solver.SetNumBooleanVariables(variable_count);
+}
+
+void Solver_clause_sink::add_hard_clause(vector<int32_t>& clause)
+{
+	solver.AddHardClause(clause);
+	clause_count++;
+}
+
+void Solver_clause_sink::add_soft_clause(vector<int32_t>& clause, int64_t weight)
+{
+	solver.AddSoftClause(clause, weight);
+	clause_count++;
+}
+
+int Reachability_index::add_node()
+{
+	if (released_nodes.size() > 0) {
+		int node = released_nodes.back();
+		released_nodes.pop_back();
+		return node;
+	}
+
+	int node = reachable.size();
+	if (node >= word_count * 64) {
+		word_count = max(1, word_count * 2);
+		for (vector<uint64_t>& row : reachable)
+		{
+			row.resize(word_count, 0);
+		}
+	}
+	reachable.push_back(vector<uint64_t>(word_count, 0));
+	return node;
+}
+
+void Reachability_index::add_edge(int from, int to)
+{
+	// Every node reaching from, and from itself, now also reaches to and everything reached by to
+	vector<uint64_t> reached_through_edge = reachable[to];
+	insert(reached_through_edge, to);
+	for (int node = 0; node < reachable.size(); node++)
+	{
+		if (node == from || contains(reachable[node], from))
+		{
+			for (int k = 0; k < word_count; k++)
+			{
+				reachable[node][k] |= reached_through_edge[k];
+			}
+		}
+	}
+}
+
+void Reachability_index::release_node(int node)
+{
+	fill(reachable[node].begin(), reachable[node].end(), 0);
+	for (vector<uint64_t>& row : reachable)
+	{
+		row[node >> 6] &= ~(uint64_t(1) << (node & 63));
+	}
+	released_nodes.push_back(node);
+}
+
+bool Reachability_index::reaches_any(int node, vector<uint64_t>& nodes)
+{
+	for (int k = 0; k < word_count; k++)
+	{
+		if ((reachable[node][k] & nodes[k]) != 0) {
+			return true;
+		}
+	}
+	return false;
+}
+
+vector<uint64_t> Reachability_index::create_node_set()
+{
+	return vector<uint64_t>(word_count, 0);
+}
+
+void Reachability_index::insert(vector<uint64_t>& nodes, int node)
+{
+	nodes[node >> 6] |= uint64_t(1) << (node & 63);
+}
+
+bool Reachability_index::contains(vector<uint64_t>& nodes, int node)
+{
+	return (nodes[node >> 6] >> (node & 63)) & 1;
+}
+
+void Resource_profile::reset(int horizon, vector<int>& resource_availabilities)
+{
+	this->resource_availabilities = resource_availabilities;
+	time_count = 0;
+	remaining_capacity.clear();
+	grow(horizon);
+}
+
+void Resource_profile::grow(int new_time_count)
+{
+	// Time units past the horizon have the full capacity
+	for (; time_count < new_time_count; time_count++)
+	{
+		remaining_capacity.insert(remaining_capacity.end(), resource_availabilities.begin(), resource_availabilities.end());
+	}
+}
+
+int Resource_profile::find_earliest_start_time(int duration, vector<int>& resource_requirements, int earliest_start_time)
+{
+	int resource_count = resource_availabilities.size();
+	for (int resource = 0; resource < resource_count; resource++)
+	{
+		if (resource_requirements[resource] > resource_availabilities[resource]) {
+			throw runtime_error("resource requirement exceeds the resource availability");
+		}
+	}
+
+	bool found_possible_timeslot = false;
+	while (!found_possible_timeslot)
+	{
+		if (earliest_start_time + duration > time_count) {
+			grow(earliest_start_time + duration);
+		}
+
+		// Every start up to the last conflicting time unit in the window overlaps that time unit as well
+		int last_conflict = -1;
+		for (int t = earliest_start_time + duration - 1; t >= earliest_start_time && last_conflict < 0; t--)
+		{
+			const int* remaining = &remaining_capacity[t * resource_count];
+			for (int resource = 0; resource < resource_count; resource++)
+			{
+				if (resource_requirements[resource] > remaining[resource]) {
+					last_conflict = t;
+					break;
+				}
+			}
+		}
+		if (last_conflict >= 0) {
+			earliest_start_time = last_conflict + 1;
+		}
+		else {
+			found_possible_timeslot = true;
+		}
+	}
+
+	return earliest_start_time;
+}
+
+void Resource_profile::reserve(int start_time, int duration, vector<int>& resource_requirements)
+{
+	int resource_count = resource_availabilities.size();
+	if (start_time + duration > time_count) {
+		grow(start_time + duration);
+	}
+	for (int t = start_time; t < start_time + duration; t++)
+	{
+		int* remaining = &remaining_capacity[t * resource_count];
+		for (int resource = 0; resource < resource_count; resource++)
+		{
+			remaining[resource] -= resource_requirements[resource];
+		}
+	}
+}
+
+void Resource_profile::release(int start_time, int duration, vector<int>& resource_requirements)
+{
+	int resource_count = resource_availabilities.size();
+	for (int t = start_time; t < start_time + duration; t++)
+	{
+		int* remaining = &remaining_capacity[t * resource_count];
+		for (int resource = 0; resource < resource_count; resource++)
+		{
+			remaining[resource] += resource_requirements[resource];
+		}
+	}
+}
+
+void Heuristic_Solver::set_budget(double time_limit_seconds, long long iteration_limit, long long stagnation_limit)
+{
+	time_limit_milliseconds = (long long)(time_limit_seconds * 1000);
+	this->iteration_limit = iteration_limit;
+	this->stagnation_limit = stagnation_limit;
+}
+
+void Heuristic_Solver::set_improvement_callback(function<void(int, double)> improvement_callback)
+{
+	this->improvement_callback = improvement_callback;
+}
+
+void Heuristic_Solver::set_solution_callback(function<void(Solution&)> solution_callback)
+{
+	this->solution_callback = solution_callback;
+}
+
+void Heuristic_Solver::submit_task_order(vector<int> task_order)
+{
+	lock_guard<mutex> lock(external_control->task_order_mutex);
+	external_control->task_order = task_order;
+	external_control->has_task_order = true;
+}
+
+void Heuristic_Solver::set_lower_bound(int lower_bound)
+{
+	int current_lower_bound = external_control->lower_bound.load();
+	while (lower_bound > current_lower_bound && !external_control->lower_bound.compare_exchange_weak(current_lower_bound, lower_bound));
+}
+
+void Heuristic_Solver::stop()
+{
+	external_control->stop_requested = true;
+}
+
 int Heuristic_Solver::solve(string project_lib_folder, string project_lib_file, int setup_time)
 {
+	search_start = chrono::steady_clock::now();
+
 #pragma region setup
 	parse_activities(project_lib_folder + project_lib_file);
 	calculate_rurs();
+	build_reachability_index();
 #pragma endregion
 
 #pragma region initial schedule
-	vector<Task> initial_task_list = initial_tasks;
+	vector<int> initial_task_list(initial_task_count);
 	vector<int> initial_start_times;
 	int initial_makespan;
 
-	sort(initial_task_list.begin() + 1, initial_task_list.end() - 1, greater<Task>());
+	for (int i = 0; i < initial_task_count; i++)
+	{
+		initial_task_list[i] = i;
+	}
+	sort(initial_task_list.begin() + 1, initial_task_list.end() - 1, [this](int lhs, int rhs) {return tasks.rur[tasks.task_id[lhs]] > tasks.rur[tasks.task_id[rhs]]; });
 	fix_presedence_constraint(initial_task_list);
 	construct_initial_task_list(initial_task_list);
 	initial_makespan = construct_schedule(initial_task_list, initial_start_times, initial_task_count);
@@ -78,28 +578,51 @@ int Heuristic_Solver::solve(string project_lib_folder, string project_lib_file,
 	// from here on all (global) variables with the initial_ preamble will not be modified
 
 #pragma region algorithm
-	vector<Task> task_list = initial_task_list;
+	vector<int> task_list = initial_task_list;
 	makespan = initial_makespan;
+	report_improvement(task_list);
+	unsplit_state = make_shared<const Incumbent>(Incumbent{ makespan, task_list, tasks, job_id, reachability, reachability_node });
 
+	long long iterations = 0;
+	long long last_improvement_iteration = 0;
+
+	// Improve the task order without preemption until 20 iterations in a row find nothing better
 	int no_better_solution_found = 0;
-	while (no_better_solution_found > 20) {
+	while (no_better_solution_found < 20 && !is_budget_exhausted(iterations, last_improvement_iteration)) {
 		int new_makespan = optimize_task_list(makespan, task_list, false, setup_time);
+		iterations++;
 		if (new_makespan == makespan) {
 			no_better_solution_found++;
 		}
 		else {
 			no_better_solution_found = 0;
+			makespan = new_makespan;
+			last_improvement_iteration = iterations;
+			report_improvement(task_list);
 		}
-		makespan = new_makespan;
 	}
 
-	vector<int> start_times = vector<int>(job_id.get_max_id(), 0);
-	construct_schedule(task_list, start_times, job_id.get_max_id());
+	if (heuristic_threads > 1) {
+		solve_parallel(task_list, setup_time, iterations, last_improvement_iteration);
+	}
+	else {
+		while (!is_budget_exhausted(iterations, last_improvement_iteration)) {
+			if (adopt_submitted_task_order(task_list)) {
+				last_improvement_iteration = iterations;
+				report_improvement(task_list);
+			}
 
-	while (true) {
-		makespan = optimize_task_list(makespan, task_list, true, setup_time);
+			int new_makespan = optimize_task_list(makespan, task_list, true, setup_time);
+			iterations++;
+			if (new_makespan < makespan) {
+				makespan = new_makespan;
+				last_improvement_iteration = iterations;
+				report_improvement(task_list);
+			}
+		}
 	}
 
+	best_solution = create_solution(task_list);
 #pragma endregion
 
 	return makespan;
@@ -107,9 +630,208 @@ int Heuristic_Solver::solve(string project_lib_folder, string project_lib_file,
 
 int Heuristic_Solver::get_best_makespan()
 {
+	if (shared_incumbent) {
+		return shared_incumbent->makespan.load();
+	}
 	return makespan;
 }
 
+Heuristic_Solver::Solution Heuristic_Solver::get_best_solution()
+{
+	return best_solution;
+}
+
+bool Heuristic_Solver::is_budget_exhausted(long long iterations, long long last_improvement_iteration)
+{
+	if (external_control->stop_requested || get_best_makespan() <= external_control->lower_bound) {
+		return true;
+	}
+	if (iteration_limit > 0 && iterations >= iteration_limit) {
+		return true;
+	}
+	if (stagnation_limit > 0 && iterations - last_improvement_iteration >= stagnation_limit) {
+		return true;
+	}
+	return time_limit_milliseconds > 0 && chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() - search_start).count() >= time_limit_milliseconds;
+}
+
+double Heuristic_Solver::get_elapsed_seconds()
+{
+	return chrono::duration<double>(chrono::steady_clock::now() - search_start).count();
+}
+
+void Heuristic_Solver::report_improvement(vector<int>& task_list)
+{
+	if (improvement_callback) {
+		improvement_callback(makespan, get_elapsed_seconds());
+	}
+	if (solution_callback) {
+		Solution solution = create_solution(task_list);
+		solution_callback(solution);
+	}
+}
+
+Heuristic_Solver::Solution Heuristic_Solver::create_solution(vector<int>& task_list)
+{
+	vector<int> start_times;
+	construct_schedule(task_list, start_times, job_id.get_max_id());
+
+	Solution solution;
+	solution.makespan = makespan;
+	for (int split_task_id : task_list)
+	{
+		solution.task_ids.push_back(tasks.task_id[split_task_id]);
+		solution.durations.push_back(tasks.duration[split_task_id]);
+		solution.start_times.push_back(start_times[split_task_id]);
+	}
+	return solution;
+}
+
+// Schedules the latest submitted order on the parsed tasks without any split and replaces the current solution if that is better
+bool Heuristic_Solver::adopt_submitted_task_order(vector<int>& task_list)
+{
+	if (!external_control->has_task_order || !unsplit_state) {
+		return false;
+	}
+
+	vector<int> task_order;
+	{
+		lock_guard<mutex> lock(external_control->task_order_mutex);
+		task_order.swap(external_control->task_order);
+		external_control->has_task_order = false;
+	}
+	if (task_order.size() != initial_task_count) {
+		return false;
+	}
+
+	Incumbent current_state{ makespan, task_list, tasks, job_id, reachability, reachability_node };
+	tasks = unsplit_state->tasks;
+	job_id = unsplit_state->job_id;
+	reachability = unsplit_state->reachability;
+	reachability_node = unsplit_state->reachability_node;
+
+	fix_presedence_constraint(task_order);
+	int new_makespan = calculate_makespan(task_order, job_id.get_max_id());
+	if (new_makespan < makespan) {
+		makespan = new_makespan;
+		task_list = task_order;
+		return true;
+	}
+
+	tasks = current_state.tasks;
+	job_id = current_state.job_id;
+	reachability = current_state.reachability;
+	reachability_node = current_state.reachability_node;
+	return false;
+}
+
+// Runs heuristic_threads independent searches from the same task list, each on its own copy of the solver, until the budget is
+// exhausted and continues with the best solution found by any of them
+void Heuristic_Solver::solve_parallel(vector<int>& task_list, int setup_time, long long iterations, long long last_improvement_iteration)
+{
+	static_assert(atomic<const Incumbent*>::is_always_lock_free, "The incumbent slot must be lock-free");
+	shared_incumbent = make_shared<Shared_incumbent>();
+	shared_incumbent->published_solutions.resize(heuristic_threads + 1);
+	shared_incumbent->iterations = iterations;
+	shared_incumbent->last_improvement_iteration = last_improvement_iteration;
+	worker_index = heuristic_threads;
+	publish_incumbent(task_list, iterations);
+
+	vector<Heuristic_Solver> workers(heuristic_threads, *this);
+	vector<thread> worker_threads;
+	for (int i = 0; i < heuristic_threads; i++)
+	{
+		worker_threads.push_back(thread(&Heuristic_Solver::run_worker, &workers[i], i, task_list, setup_time));
+	}
+	for (thread& worker_thread : worker_threads)
+	{
+		worker_thread.join();
+	}
+
+	adopt_incumbent(task_list);
+}
+
+void Heuristic_Solver::run_worker(int worker_index, vector<int> task_list, int setup_time)
+{
+	this->worker_index = worker_index;
+	use_random_generator = true;
+	random_generator.seed(worker_index + 1);
+
+	int iterations_since_restart = 0;
+	while (true) {
+		long long iteration = shared_incumbent->iterations++;
+		if (is_budget_exhausted(iteration, shared_incumbent->last_improvement_iteration.load())) {
+			break;
+		}
+
+		if (adopt_submitted_task_order(task_list)) {
+			publish_incumbent(task_list, iteration);
+		}
+
+		int new_makespan = optimize_task_list(makespan, task_list, true, setup_time);
+		if (new_makespan < makespan) {
+			makespan = new_makespan;
+			publish_incumbent(task_list, iteration + 1);
+		}
+
+		iterations_since_restart++;
+		if (iterations_since_restart >= heuristic_restart_interval) {
+			adopt_incumbent(task_list);
+			iterations_since_restart = 0;
+		}
+	}
+}
+
+// Replaces the shared solution if the makespan of this worker is better, the solution pointer only ever moves to a better
+// solution so concurrent publishers cannot overwrite a better solution with a worse one
+void Heuristic_Solver::publish_incumbent(vector<int>& task_list, long long iteration)
+{
+	const Incumbent* solution = shared_incumbent->solution.load();
+	if (solution && solution->makespan <= makespan) {
+		return;
+	}
+
+	unique_ptr<const Incumbent> new_solution = make_unique<const Incumbent>(Incumbent{ makespan, task_list, tasks, job_id, reachability, reachability_node });
+	while (!solution || new_solution->makespan < solution->makespan)
+	{
+		if (shared_incumbent->solution.compare_exchange_weak(solution, new_solution.get())) {
+			shared_incumbent->published_solutions[worker_index].push_back(std::move(new_solution));
+			int best_makespan = shared_incumbent->makespan.load();
+			while (makespan < best_makespan && !shared_incumbent->makespan.compare_exchange_weak(best_makespan, makespan));
+			shared_incumbent->last_improvement_iteration = iteration;
+
+			if (solution) {
+				lock_guard<mutex> lock(shared_incumbent->improvement_callback_mutex);
+				report_improvement(task_list);
+			}
+			return;
+		}
+	}
+}
+
+void Heuristic_Solver::adopt_incumbent(vector<int>& task_list)
+{
+	const Incumbent* solution = shared_incumbent->solution.load();
+	if (!solution || solution->makespan >= makespan) {
+		return;
+	}
+
+	makespan = solution->makespan;
+	task_list = solution->task_list;
+	tasks = solution->tasks;
+	job_id = solution->job_id;
+	reachability = solution->reachability;
+	reachability_node = solution->reachability_node;
+}
+
+int Heuristic_Solver::get_random_number()
+{
+	if (use_random_generator) {
+		return random_generator() & INT_MAX;
+	}
+	return rand();
+}
+
 void Heuristic_Solver::parse_activities(string filename)
 {
 	string tmp;
@@ -128,28 +850,31 @@ void Heuristic_Solver::parse_activities(string filename)
 		project_lib >> resource_availabilities[i];
 	}
 
-	initial_tasks = vector<Task>(initial_task_count);
+	tasks = Task_store();
+	tasks.resource_requirements = vector<vector<int>>(initial_task_count);
 	for (int i = 0; i < initial_task_count; i++)
 	{
 		int parsed_task_id;
 		project_lib >> parsed_task_id;
-		initial_tasks[i].task_id = job_id.get_next_id();
-		initial_tasks[i].split_task_id = initial_tasks[i].task_id;
+		int task_id = job_id.get_next_id();
+		tasks.task_id.push_back(task_id);
 
-		initial_tasks[i].resource_requirements = vector<int>(resource_count);
+		tasks.resource_requirements[task_id] = vector<int>(resource_count);
 		for (int j = 0; j < resource_count; j++)
 		{
-			project_lib >> initial_tasks[i].resource_requirements[j];
+			project_lib >> tasks.resource_requirements[task_id][j];
 		}
 
-		project_lib >> initial_tasks[i].duration;
+		int duration;
+		project_lib >> duration;
+		tasks.duration.push_back(duration);
 
 		int successor_count;
 		project_lib >> successor_count;
-		initial_tasks[i].successors = vector<int>(successor_count);
+		tasks.successors.push_back(vector<int>(successor_count));
 		for (int j = 0; j < successor_count; j++)
 		{
-			project_lib >> initial_tasks[i].successors[j];
+			project_lib >> tasks.successors[task_id][j];
 		}
 	}
 
@@ -161,20 +886,85 @@ void Heuristic_Solver::parse_activities(string filename)
 
 void Heuristic_Solver::calculate_rurs()
 {
+	tasks.rur = vector<double>(initial_task_count);
 	for (int i = 0; i < initial_task_count; i++)
 	{
-		initial_tasks[i].calculate_rur(resource_availabilities);
+		tasks.rur[i] = 0;
+		for (int j = 0; j < resource_count; j++)
+		{
+			tasks.rur[i] += (double)tasks.resource_requirements[i][j] / (double)resource_availabilities[j];
+		}
+		tasks.rur[i] *= tasks.duration[i];
+	}
+}
+
+// Creates a part of the task split_task_id with the given duration and the first successor_count successors of the task
+int Heuristic_Solver::create_task_part(int split_task_id, int duration, int successor_count)
+{
+	int part_split_task_id = job_id.get_next_id();
+	assert(part_split_task_id == tasks.task_id.size());
+	tasks.task_id.push_back(tasks.task_id[split_task_id]);
+	tasks.duration.push_back(duration);
+	tasks.successors.emplace_back(tasks.successors[split_task_id].begin(), tasks.successors[split_task_id].begin() + successor_count);
+	return part_split_task_id;
+}
+
+void Heuristic_Solver::release_task_part(int split_task_id)
+{
+	vector<int>().swap(tasks.successors[split_task_id]);
+	release_reachability_node(split_task_id);
+}
+
+void Heuristic_Solver::build_reachability_index()
+{
+	reachability = Reachability_index();
+	reachability_node.clear();
+	for (int i = 0; i < initial_task_count; i++)
+	{
+		get_reachability_node(i);
+	}
+	for (int i = 0; i < initial_task_count; i++)
+	{
+		add_reachability_edges(i);
+	}
+}
+
+int Heuristic_Solver::get_reachability_node(int split_task_id)
+{
+	if (split_task_id >= reachability_node.size()) {
+		reachability_node.resize(split_task_id + 1, -1);
+	}
+	if (reachability_node[split_task_id] < 0) {
+		reachability_node[split_task_id] = reachability.add_node();
+	}
+	return reachability_node[split_task_id];
+}
+
+void Heuristic_Solver::add_reachability_edges(int split_task_id)
+{
+	int node = get_reachability_node(split_task_id);
+	for (int successor : tasks.successors[split_task_id])
+	{
+		reachability.add_edge(node, get_reachability_node(successor));
+	}
+}
+
+void Heuristic_Solver::release_reachability_node(int split_task_id)
+{
+	if (split_task_id < reachability_node.size() && reachability_node[split_task_id] >= 0) {
+		reachability.release_node(reachability_node[split_task_id]);
+		reachability_node[split_task_id] = -1;
 	}
 }
 
-void Heuristic_Solver::fix_presedence_constraint(vector<Task>& task_list)
+void Heuristic_Solver::fix_presedence_constraint(vector<int>& task_list)
 {
 	vector<int> task_in_violation_at_index;
 
-	bool presedence_violated = check_presedence_violation(task_list, task_in_violation_at_index, task_list);
+	bool presedence_violated = check_presedence_violation(task_list, task_in_violation_at_index);
 	while (presedence_violated) {
 		move(task_list, task_in_violation_at_index[0], task_in_violation_at_index[1]);
-		presedence_violated = check_presedence_violation(task_list, task_in_violation_at_index, task_list);
+		presedence_violated = check_presedence_violation(task_list, task_in_violation_at_index);
 	}
 }
 
@@ -190,43 +980,42 @@ template <typename t> void Heuristic_Solver::move(vector<t>& v, size_t oldIndex,
 	}
 }
 
-template<typename T> vector<T> Heuristic_Solver::flatten(vector<vector<T>> const& vec)
-{
-	vector<T> flattened;
-	for (auto const& v : vec) {
-		flattened.insert(flattened.end(), v.begin(), v.end());
-	}
-	return flattened;
-}
-
-bool Heuristic_Solver::check_presedence_violation(vector<Task>& task_list, vector<int>& task_in_violation_at_index, vector<Task>& complete_task_list)
+bool Heuristic_Solver::check_presedence_violation(vector<int>& task_list, vector<int>& task_in_violation_at_index)
 {
+	vector<uint64_t> preceding_tasks = reachability.create_node_set();
+	Reachability_index::insert(preceding_tasks, get_reachability_node(task_list[0]));
 	for (int i = 1; i < task_list.size(); i++)
 	{
-		vector<int> successors = task_list[i].successors;
-		while (successors.size() > 0)
+		int node = get_reachability_node(task_list[i]);
+		if (!reachability.reaches_any(node, preceding_tasks)) {
+			Reachability_index::insert(preceding_tasks, node);
+			continue;
+		}
+
+		// The violated successor is the first preceding task found when exploring the successors breadth first
+		vector<int> successors = tasks.successors[task_list[i]];
+		vector<bool> explored(job_id.get_max_id(), false);
+		for (int k = 0; k < successors.size(); k++)
 		{
-			int successor = successors[0];
-			successors.erase(successors.begin());
+			int successor = successors[k];
+			if (explored[successor])
+			{
+				continue;
+			}
+			explored[successor] = true;
 			for (int j = 0; j < i; j++)
 			{
-				if (task_list[j].split_task_id == successor) {
+				if (task_list[j] == successor) {
 					task_in_violation_at_index = { i,j };
 					return true;
 				}
 			}
-			for (int j = 0; j < complete_task_list.size(); j++)
+			if (find(task_list.begin(), task_list.end(), successor) != task_list.end())
 			{
-				if (complete_task_list[j].split_task_id == successor)
-				{
-					for (int k = 0; k < complete_task_list[j].successors.size(); k++)
-					{
-						successors.push_back(complete_task_list[j].successors[k]);
-					}
-					break;
-				}
+				successors.insert(successors.end(), tasks.successors[successor].begin(), tasks.successors[successor].end());
 			}
 		}
+		throw runtime_error("reachability index is inconsistent with the task successors");
 	}
 
 	return false;
@@ -246,10 +1035,25 @@ bool Heuristic_Solver::check_presedence_violation(vector<Task>& task_list, vecto
 	//return false;
 }
 
-void Heuristic_Solver::construct_initial_task_list(vector<Task>& task_list)
+bool Heuristic_Solver::has_presedence_violation(vector<int>& task_list)
 {
-	vector<Task> new_task_list;
-	vector<Task> remaining_task_list;
+	vector<uint64_t> preceding_tasks = reachability.create_node_set();
+	for (int i = 0; i < task_list.size(); i++)
+	{
+		int node = get_reachability_node(task_list[i]);
+		if (reachability.reaches_any(node, preceding_tasks)) {
+			return true;
+		}
+		Reachability_index::insert(preceding_tasks, node);
+	}
+
+	return false;
+}
+
+void Heuristic_Solver::construct_initial_task_list(vector<int>& task_list)
+{
+	vector<int> new_task_list;
+	vector<int> remaining_task_list;
 	new_task_list.push_back(task_list[0]);
 	new_task_list.push_back(task_list[1]);
 
@@ -258,24 +1062,9 @@ void Heuristic_Solver::construct_initial_task_list(vector<Task>& task_list)
 		remaining_task_list.push_back(task_list[i]);
 	}
 
-	while (remaining_task_list.size() > 0) {
-		int minimum_makespan = horizon;
-		int optimal_index = -1;
-		Task to_schedule_task = remaining_task_list[0];
-		remaining_task_list.erase(remaining_task_list.begin());
-		for (int i = 0; i <= new_task_list.size(); i++)
-		{
-			new_task_list.insert(new_task_list.begin() + i, to_schedule_task);
-			vector<int>tmp(2);
-			if (!check_presedence_violation(new_task_list, tmp, task_list)) {
-				int makespan_test = calculate_makespan(new_task_list, initial_task_count);
-				if (makespan_test < minimum_makespan) {
-					minimum_makespan = makespan_test;
-					optimal_index = i;
-				}
-			}
-			new_task_list.erase(new_task_list.begin() + i);
-		}
+	for (int to_schedule_task : remaining_task_list)
+	{
+		int optimal_index = find_best_insertion_index(new_task_list, to_schedule_task, new_task_list.size() + 1, initial_task_count);
 		assert(optimal_index >= 0);
 		new_task_list.insert(new_task_list.begin() + optimal_index, to_schedule_task);
 	}
@@ -283,274 +1072,589 @@ void Heuristic_Solver::construct_initial_task_list(vector<Task>& task_list)
 	task_list = new_task_list;
 }
 
-int Heuristic_Solver::calculate_makespan(vector<Task>& task_list, int task_count)
+int Heuristic_Solver::calculate_makespan(vector<int>& task_list, int task_count)
 {
-	vector<vector<int>> remaining_resources;
-	for (int i = 0; i < horizon; i++)
+	reset_schedule_state(task_count);
+	for (int i = 0; i < task_list.size(); i++)
 	{
-		remaining_resources.push_back(resource_availabilities);
+		schedule_task(task_list[i]);
 	}
 
-	vector<int> start_times(task_count, 0);
+	return schedule_state.start_times[initial_task_count - 1];
+}
 
+int Heuristic_Solver::construct_schedule(vector<int>& task_list, vector<int>& start_times, int task_count)
+{
+	reset_schedule_state(task_count);
 	for (int i = 0; i < task_list.size(); i++)
 	{
-		int earliest_start_time = find_earliest_start_time(task_list[i].duration, task_list[i].resource_requirements, remaining_resources, start_times[task_list[i].split_task_id]);
-		start_times[task_list[i].split_task_id] = earliest_start_time;
-		for (int j = 0; j < task_list[i].duration; j++)
+		schedule_task(task_list[i]);
+	}
+
+	start_times = schedule_state.start_times;
+	return start_times.back();
+}
+
+void Heuristic_Solver::reset_schedule_state(int task_count)
+{
+	schedule_state.resource_profile.reset(horizon, resource_availabilities);
+	schedule_state.start_times.assign(task_count, 0);
+	schedule_state.record_changes = false;
+	schedule_state.start_time_changes.clear();
+	schedule_state.reservations.clear();
+}
+
+void Heuristic_Solver::schedule_task(int split_task_id)
+{
+	int duration = tasks.duration[split_task_id];
+	vector<int>& resource_requirements = tasks.resource_requirements[tasks.task_id[split_task_id]];
+	int earliest_start_time = schedule_state.resource_profile.find_earliest_start_time(duration, resource_requirements, schedule_state.start_times[split_task_id]);
+	set_start_time(split_task_id, earliest_start_time);
+	schedule_state.resource_profile.reserve(earliest_start_time, duration, resource_requirements);
+	if (schedule_state.record_changes) {
+		schedule_state.reservations.push_back(pair<int, int>(earliest_start_time, split_task_id));
+	}
+
+	for (int successor : tasks.successors[split_task_id])
+	{
+		if (earliest_start_time + duration > schedule_state.start_times[successor])
 		{
-			for (int k = 0; k < task_list[i].resource_requirements.size(); k++)
-			{
-				remaining_resources[earliest_start_time + j][k] = remaining_resources[earliest_start_time + j][k] - task_list[i].resource_requirements[k];
-			}
+			set_start_time(successor, earliest_start_time + duration);
 		}
+	}
+}
 
-		for (int j = 0; j < task_list[i].successors.size(); j++)
+void Heuristic_Solver::set_start_time(int split_task_id, int start_time)
+{
+	if (schedule_state.record_changes) {
+		schedule_state.start_time_changes.push_back(pair<int, int>(split_task_id, schedule_state.start_times[split_task_id]));
+	}
+	schedule_state.start_times[split_task_id] = start_time;
+}
+
+void Heuristic_Solver::undo_recorded_changes()
+{
+	for (int i = schedule_state.reservations.size() - 1; i >= 0; i--)
+	{
+		int split_task_id = schedule_state.reservations[i].second;
+		schedule_state.resource_profile.release(schedule_state.reservations[i].first, tasks.duration[split_task_id], tasks.resource_requirements[tasks.task_id[split_task_id]]);
+	}
+	for (int i = schedule_state.start_time_changes.size() - 1; i >= 0; i--)
+	{
+		schedule_state.start_times[schedule_state.start_time_changes[i].first] = schedule_state.start_time_changes[i].second;
+	}
+	schedule_state.reservations.clear();
+	schedule_state.start_time_changes.clear();
+}
+
+// Equivalent to inserting the task at every index below insertion_count and keeping the precedence feasible insertion with the
+// smallest makespan below the horizon, the earliest index on ties, returns -1 if there is none. The schedule of the prefix
+// before the insertion index is shared between the candidates so only the inserted task and the suffix are rescheduled.
+int Heuristic_Solver::find_best_insertion_index(vector<int>& task_list, int split_task_id, int insertion_count, int task_count)
+{
+	if (has_presedence_violation(task_list)) {
+		return -1;
+	}
+
+	// The insertion violates the precedences if the task reaches a task in the prefix or a task in the suffix reaches the task
+	int task_node = get_reachability_node(split_task_id);
+	vector<uint64_t> task_set = reachability.create_node_set();
+	Reachability_index::insert(task_set, task_node);
+	vector<bool> suffix_reaches_task(task_list.size() + 1, false);
+	for (int i = task_list.size() - 1; i >= 0; i--)
+	{
+		suffix_reaches_task[i] = suffix_reaches_task[i + 1] || reachability.reaches_any(get_reachability_node(task_list[i]), task_set);
+	}
+	vector<uint64_t> prefix_tasks = reachability.create_node_set();
+
+	int sink_id = initial_task_count - 1;
+	int minimum_makespan = horizon;
+	int optimal_insertion_index = -1;
+	reset_schedule_state(task_count);
+	for (int k = 0; k < insertion_count; k++)
+	{
+		if (!suffix_reaches_task[k] && !reachability.reaches_any(task_node, prefix_tasks))
 		{
-			if (earliest_start_time + task_list[i].duration > start_times[task_list[i].successors[j]])
+			// The sink start time never decreases while scheduling, so a candidate is abandoned as soon as it cannot improve
+			schedule_state.record_changes = true;
+			schedule_task(split_task_id);
+			for (int i = k; i < task_list.size() && schedule_state.start_times[sink_id] < minimum_makespan; i++)
 			{
-				start_times[task_list[i].successors[j]] = earliest_start_time + task_list[i].duration;
+				schedule_task(task_list[i]);
+			}
+			int makespan_test = schedule_state.start_times[sink_id];
+			undo_recorded_changes();
+			schedule_state.record_changes = false;
+
+			if (makespan_test < minimum_makespan) {
+				minimum_makespan = makespan_test;
+				optimal_insertion_index = k;
 			}
 		}
+
+		if (k < task_list.size()) {
+			schedule_task(task_list[k]);
+			Reachability_index::insert(prefix_tasks, get_reachability_node(task_list[k]));
+		}
 	}
 
-	return start_times[initial_task_count - 1];
+	return optimal_insertion_index;
 }
 
-int Heuristic_Solver::construct_schedule(vector<Task>& task_list, vector<int>& start_times, int task_count)
+int Heuristic_Solver::optimize_task_list(int makespan, vector<int>& task_list, bool preempt_tasks, int setup_time)
 {
-	vector<vector<int>> remaining_resources;
-	for (int i = 0; i < horizon; i++)
+	vector<int> new_task_list = task_list;
+
+	vector<int> destruction_ids;
+	vector<vector<vector<int>>> destruction_split_ids;
+	vector<int> created_task_ids;
+	vector<pair<int, int>> successor_list_sizes; // split task id, size of the successor list before appending the parts of a split task
+	assert(destruction_count > 0);
+	for (int i = 0; i < destruction_count; i++)
 	{
-		remaining_resources.push_back(resource_availabilities);
-	}
 
-	vector<int> new_start_times(task_count, 0);
+		int random_task_index = (get_random_number() % (task_list.size() - 1)) + 1;
+		int random_task_id = task_list[random_task_index];
+		while (random_task_id == initial_task_count - 1 || find(destruction_ids.begin(), destruction_ids.end(), random_task_id) != destruction_ids.end()) {
+			random_task_index = (get_random_number() % (task_list.size() - 1)) + 1;
+			random_task_id = task_list[random_task_index];
+		}
 
-	for (int i = 0; i < task_list.size(); i++)
-	{
-		int earliest_start_time = find_earliest_start_time(task_list[i].duration, task_list[i].resource_requirements, remaining_resources, new_start_times[task_list[i].split_task_id]);
-		new_start_times[task_list[i].split_task_id] = earliest_start_time;
-		for (int j = 0; j < task_list[i].duration; j++)
+		destruction_ids.push_back(random_task_id);
+
+		int to_be_destroyed = random_task_id;
+		int to_be_destroyed_duration = tasks.duration[to_be_destroyed];
+
+		if (!preempt_tasks || to_be_destroyed_duration <= 1)
+		{
+			destruction_split_ids.push_back(vector<vector<int>> {vector<int>{to_be_destroyed}});
+		}
+		else
 		{
-			for (int k = 0; k < task_list[i].resource_requirements.size(); k++)
+			int split_index = (get_random_number() % (to_be_destroyed_duration - 1)) + 1;
+
+			// The parts take all successors of the task, including the parts of tasks split earlier in this iteration
+			int successor_count = tasks.successors[to_be_destroyed].size();
+			int to_be_destroyed_begin = create_task_part(to_be_destroyed, split_index, successor_count);
+			int to_be_destroyed_end = create_task_part(to_be_destroyed, to_be_destroyed_duration - split_index + setup_time, successor_count);
+
+			tasks.successors[to_be_destroyed_begin].push_back(to_be_destroyed_end);
+
+			new_task_list.push_back(to_be_destroyed_begin);
+			new_task_list.push_back(to_be_destroyed_end);
+
+			created_task_ids.push_back(to_be_destroyed_begin);
+			created_task_ids.push_back(to_be_destroyed_end);
+			add_reachability_edges(to_be_destroyed_begin);
+			add_reachability_edges(to_be_destroyed_end);
+
+			for (int j = 0; j < new_task_list.size(); j++)
 			{
-				remaining_resources[earliest_start_time + j][k] = remaining_resources[earliest_start_time + j][k] - task_list[i].resource_requirements[k];
+				vector<int>& successors = tasks.successors[new_task_list[j]];
+				if (find(successors.begin(), successors.end(), to_be_destroyed) != successors.end())
+				{
+					successor_list_sizes.push_back(pair<int, int>(new_task_list[j], successors.size()));
+					successors.push_back(to_be_destroyed_begin);
+					successors.push_back(to_be_destroyed_end);
+					reachability.add_edge(get_reachability_node(new_task_list[j]), get_reachability_node(to_be_destroyed_begin));
+					reachability.add_edge(get_reachability_node(new_task_list[j]), get_reachability_node(to_be_destroyed_end));
+				}
 			}
+
+			destruction_split_ids.push_back(vector<vector<int>> {vector<int>{to_be_destroyed}, vector<int>{to_be_destroyed_begin, to_be_destroyed_end}});
 		}
+	}
 
-		for (int j = 0; j < task_list[i].successors.size(); j++)
+	vector<int> remaining_tasks = new_task_list;
+	for (vector<vector<int>>& destroyed_task : destruction_split_ids)
+	{
+		for (vector<int>& destroyed_task_parts : destroyed_task)
 		{
-			if (earliest_start_time + task_list[i].duration > new_start_times[task_list[i].successors[j]])
+			for (int destroyed_task_part : destroyed_task_parts)
 			{
-				new_start_times[task_list[i].successors[j]] = earliest_start_time + task_list[i].duration;
+				remaining_tasks.erase(remove(remaining_tasks.begin(), remaining_tasks.end(), destroyed_task_part), remaining_tasks.end());
 			}
 		}
 	}
 
-	start_times = new_start_times;
-	return start_times.back();
-}
+	vector<int> cleanup_task_ids;
 
-int Heuristic_Solver::find_earliest_start_time(int duration, vector<int> resource_requirements, vector<vector<int>>& remaining_resources, int earliest_start_time)
-{
-	bool found_possible_timeslot = false;
-	while (!found_possible_timeslot) {
-		bool requirements_to_high = false;
-		for (int i = 0; i < duration; i++)
+	for (vector<vector<int>>& destroyed_task : destruction_split_ids)
+	{
+		pair<int, vector<int>> best_possible_task_list = pair<int, vector<int>>{ horizon, vector<int>{} };
+		vector<int> previous_best_parts;
+
+		for (int i = 0; i < destroyed_task.size(); i++)
 		{
-			for (int j = 0; j < resource_requirements.size(); j++)
+			vector<int> possible_task_list = remaining_tasks;
+			for (int j = 0; j < destroyed_task[i].size(); j++)
 			{
-				if (resource_requirements[j] > remaining_resources[earliest_start_time + i][j])
+				int optimal_insertion_index = find_best_insertion_index(possible_task_list, destroyed_task[i][j], possible_task_list.size(), job_id.get_max_id());
+				assert(optimal_insertion_index >= 0);
+				possible_task_list.insert(possible_task_list.begin() + optimal_insertion_index, destroyed_task[i][j]);
+			}
+			int possible_task_list_makespan = calculate_makespan(possible_task_list, job_id.get_max_id());
+			if (possible_task_list_makespan < best_possible_task_list.first) {
+				best_possible_task_list = pair<int, vector<int>>{ possible_task_list_makespan , possible_task_list };
+				for (int j = 0; j < previous_best_parts.size(); j++)
 				{
-					requirements_to_high = true;
+					cleanup_task_ids.push_back(previous_best_parts[j]);
+				}
+				previous_best_parts = destroyed_task[i];
+			}
+			else {
+				for (int j = 0; j < destroyed_task[i].size(); j++)
+				{
+					cleanup_task_ids.push_back(destroyed_task[i][j]);
 				}
 			}
 		}
-		if (requirements_to_high) {
-			earliest_start_time++;
-		}
-		else {
-			found_possible_timeslot = true;
+		assert(best_possible_task_list.first < horizon);
+		remaining_tasks = best_possible_task_list.second;
+	}
+
+	int makespan_test = calculate_makespan(remaining_tasks, job_id.get_max_id());
+
+	if (makespan_test < makespan)
+	{
+		for (int i = 0; i < cleanup_task_ids.size(); i++)
+		{
+			int cleanup_task_id = cleanup_task_ids[i];
+			for (int j = 0; j < remaining_tasks.size(); j++)
+			{
+				vector<int>& successors = tasks.successors[remaining_tasks[j]];
+				successors.erase(remove_if(successors.begin(), successors.end(), [&cleanup_task_id](int successor) {return successor == cleanup_task_id; }), successors.end());
+			}
+			release_task_part(cleanup_task_id);
 		}
+		task_list = remaining_tasks;
+		return makespan_test;
 	}
 
-	return earliest_start_time;
+	// Restore the successor lists and discard the parts created in this iteration
+	for (int i = successor_list_sizes.size() - 1; i >= 0; i--)
+	{
+		tasks.successors[successor_list_sizes[i].first].resize(successor_list_sizes[i].second);
+	}
+	for (int created_task_id : created_task_ids)
+	{
+		release_task_part(created_task_id);
+	}
+	return makespan;
 }
 
-int Heuristic_Solver::optimize_task_list(int makespan, vector<Task>& task_list, bool preempt_tasks, int setup_time)
+string SAT_encoder::encode(string project_lib_folder, string project_lib_file, int setup_time)
 {
-	vector<Task> new_task_list = task_list;
+	prepare_encoding(project_lib_folder, project_lib_file, setup_time);
 
-	vector<int> destruction_ids;
-	vector<vector<vector<int>>> destruction_split_ids;
-	assert(destruction_count > 0);
-	for (int i = 0; i < destruction_count; i++)
-	{
+#pragma region CNF encoding
+	write_cnf_file(preempted_tasks, project_lib_file);
+#pragma endregion
 
-		int random_task_index = (rand() % (task_list.size() - 1)) + 1;
-		int random_task_id = task_list[random_task_index].split_task_id;
-		while (random_task_id == initial_task_count - 1 || find(destruction_ids.begin(), destruction_ids.end(), random_task_id) != destruction_ids.end()) {
-			random_task_index = (rand() % (task_list.size() - 1)) + 1;
-			random_task_id = task_list[random_task_index].split_task_id;
+	return string();
+}
+
+void SAT_encoder::encode(string project_lib_folder, string project_lib_file, int setup_time, Pumpkin::ConstraintOptimisationSolver& solver)
+{
+	prepare_encoding(project_lib_folder, project_lib_file, setup_time);
+
+#pragma region CNF encoding
+	Solver_clause_sink clause_sink(solver);
+	build_clauses(preempted_tasks, clause_sink);
+#pragma endregion
+}
+
+void SAT_encoder::encode_with_propagators(string project_lib_folder, string project_lib_file, int setup_time, Pumpkin::ConstraintOptimisationSolver& solver)
+{
+	compute_time_windows(project_lib_folder, project_lib_file);
+
+	// The source always starts at 0 and needs no variables. A task is split into at most as many segments as its duration or the
+	// limit allows, and every resumed segment needs its setup time within the time window of the task.
+	int task_count = parsed_tasks.size();
+	vector<Lazy_task> lazy_tasks(task_count);
+	bool preempts_tasks = false;
+	for (int i = 1; i < task_count; i++)
+	{
+		Task& task = parsed_tasks[i];
+		int segment_count = task.duration;
+		if (lazy_segment_limit > 0) {
+			segment_count = min(segment_count, lazy_segment_limit);
 		}
+		if (setup_time > 0) {
+			segment_count = min(segment_count, 1 + (task.late_finish - task.early_start - task.duration) / setup_time);
+		}
+		segment_count = max(segment_count, 1);
+		preempts_tasks |= segment_count > 1;
+		lazy_tasks[i] = create_lazy_task(task, segment_count, setup_time, solver);
+	}
 
-		destruction_ids.push_back(random_task_id);
+	// A successor starts after the last segment of the task
+	for (int i = 1; i < task_count; i++)
+	{
+		for (int k = task_graph.successor_offsets[i]; k < task_graph.successor_offsets[i + 1]; k++)
+		{
+			add_lazy_segment_end(lazy_tasks[i], lazy_tasks[i].start_times.size() - 1, parsed_tasks[i], lazy_tasks[task_graph.successor_indices[k]].start_times[0], setup_time, solver);
+		}
+	}
 
-		Task to_be_destroyed;
-		for (int j = 0; j < task_list.size(); j++)
+	for (int resource = 0; resource < resource_availabilities.size(); resource++)
+	{
+		vector<Pumpkin::IntegerVariable> presences;
+		vector<Pumpkin::IntegerVariable> start_times;
+		vector<Pumpkin::IntegerVariable> lengths;
+		vector<int> durations; // length offsets of the segments, the whole duration for tasks with a single segment
+		vector<int> resource_requirements;
+		for (int i = 1; i < task_count - 1; i++)
 		{
-			if (task_list[j].split_task_id == random_task_id)
+			if (parsed_tasks[i].duration == 0 || parsed_tasks[i].resource_requirements[resource] == 0) {
+				continue;
+			}
+			Lazy_task& lazy_task = lazy_tasks[i];
+			for (int segment = 0; segment < lazy_task.start_times.size(); segment++)
 			{
-				to_be_destroyed = task_list[j];
+				presences.push_back(lazy_task.presences[segment]);
+				start_times.push_back(lazy_task.start_times[segment]);
+				lengths.push_back(lazy_task.lengths[segment]);
+				durations.push_back(lazy_task.start_times.size() == 1 ? parsed_tasks[i].duration : segment > 0 ? setup_time : 0);
+				resource_requirements.push_back(parsed_tasks[i].resource_requirements[resource]);
 			}
 		}
+		if (start_times.empty()) {
+			continue;
+		}
+		if (preempts_tasks) {
+			solver.AddPreemptiveCumulative(presences, start_times, lengths, durations, resource_requirements, resource_availabilities[resource]);
+		}
+		else {
+			solver.AddCumulative(start_times, durations, resource_requirements, resource_availabilities[resource]);
+		}
+	}
 
-		if (!preempt_tasks || to_be_destroyed.duration <= 1)
-		{
-			destruction_split_ids.push_back(vector<vector<int>> {vector<int>{to_be_destroyed.split_task_id}});
+	// The makespan is the start of the sink
+	solver.AddObjectiveTerm(lazy_tasks[task_count - 1].start_times[0], 1);
+}
+
+// Creates the segments of the task with the constraints that chain them: the first segment is present and the others are present
+// in order, a present segment has a length of at least one, the lengths sum up to the duration and a segment starts after the
+// previous one including the setup time of the previous one if it was resumed. Absent segments have length zero and follow the
+// chain, so the last segment always ends at the end of the task.
+SAT_encoder::Lazy_task SAT_encoder::create_lazy_task(Task& task, int segment_count, int setup_time, Pumpkin::ConstraintOptimisationSolver& solver)
+{
+	Lazy_task lazy_task;
+	lazy_task.presences = vector<Pumpkin::IntegerVariable>(segment_count);
+	lazy_task.lengths = vector<Pumpkin::IntegerVariable>(segment_count);
+	lazy_task.start_times = vector<Pumpkin::IntegerVariable>(segment_count);
+	lazy_task.start_times[0] = solver.CreateIntegerVariable(task.early_start, task.late_finish - task.duration);
+	if (segment_count == 1) {
+		return lazy_task;
+	}
+
+	lazy_task.lengths[0] = solver.CreateIntegerVariable(1, task.duration);
+	for (int segment = 1; segment < segment_count; segment++)
+	{
+		lazy_task.presences[segment] = solver.CreateIntegerVariable(0, 1);
+		lazy_task.start_times[segment] = solver.CreateIntegerVariable(task.early_start + segment, task.late_finish);
+		lazy_task.lengths[segment] = solver.CreateIntegerVariable(0, task.duration - 1);
+
+		// present if and only if the length is positive: length - presence >= 0 and (duration - 1) * presence - length >= 0
+		vector<Pumpkin::IntegerVariable> variables{ lazy_task.lengths[segment], lazy_task.presences[segment] };
+		vector<int64_t> coefficients{ 1, -1 };
+		solver.AddLinearInequality(variables, coefficients, 0);
+		coefficients = vector<int64_t>{ -1, task.duration - 1 };
+		solver.AddLinearInequality(variables, coefficients, 0);
+
+		if (segment > 1) {
+			variables = vector<Pumpkin::IntegerVariable>{ lazy_task.presences[segment - 1], lazy_task.presences[segment] };
+			coefficients = vector<int64_t>{ 1, -1 };
+			solver.AddLinearInequality(variables, coefficients, 0);
 		}
-		else
-		{
-			int split_index = (rand() % (to_be_destroyed.duration - 1)) + 1;
+		add_lazy_segment_end(lazy_task, segment - 1, task, lazy_task.start_times[segment], setup_time, solver);
+	}
 
-			Task to_be_destroyed_begin = to_be_destroyed;
-			to_be_destroyed_begin.split_task_id = job_id.get_next_id();
-			to_be_destroyed_begin.duration = split_index;
+	vector<int64_t> coefficients(segment_count, 1);
+	solver.AddLinearInequality(lazy_task.lengths, coefficients, task.duration);
+	coefficients = vector<int64_t>(segment_count, -1);
+	solver.AddLinearInequality(lazy_task.lengths, coefficients, -task.duration);
+	return lazy_task;
+}
 
-			Task to_be_destroyed_end = to_be_destroyed;
-			to_be_destroyed_end.split_task_id = job_id.get_next_id();
-			to_be_destroyed_end.duration = to_be_destroyed.duration - split_index + setup_time;
+// Adds that the segment of the task ends at or before the next start time
+void SAT_encoder::add_lazy_segment_end(Lazy_task& lazy_task, int segment, Task& task, Pumpkin::IntegerVariable next_start_time, int setup_time, Pumpkin::ConstraintOptimisationSolver& solver)
+{
+	vector<Pumpkin::IntegerVariable> variables{ next_start_time, lazy_task.start_times[segment] };
+	vector<int64_t> coefficients{ 1, -1 };
+	if (lazy_task.lengths[segment].IsNull()) {
+		solver.AddLinearInequality(variables, coefficients, task.duration);
+		return;
+	}
 
-			to_be_destroyed_begin.successors.push_back(to_be_destroyed_end.split_task_id);
+	variables.push_back(lazy_task.lengths[segment]);
+	coefficients.push_back(-1);
+	if (segment > 0 && setup_time > 0) {
+		variables.push_back(lazy_task.presences[segment]);
+		coefficients.push_back(-setup_time);
+	}
+	solver.AddLinearInequality(variables, coefficients, 0);
+}
 
-			new_task_list.push_back(to_be_destroyed_begin);
-			new_task_list.push_back(to_be_destroyed_end);
+void SAT_encoder::set_heuristic_upper_bound(int makespan)
+{
+	heuristic_upper_bound = min(heuristic_upper_bound, makespan);
+}
 
-			for (int j = 0; j < new_task_list.size(); j++)
-			{
-				if (find(new_task_list[j].successors.begin(), new_task_list[j].successors.end(), to_be_destroyed.split_task_id) != new_task_list[j].successors.end())
-				{
-					new_task_list[j].successors.push_back(to_be_destroyed_begin.split_task_id);
-					new_task_list[j].successors.push_back(to_be_destroyed_end.split_task_id);
-				}
-			}
+// Maps a schedule of the heuristic to the start and process variables. The parts of a task are matched in start time order to the
+// chain of segments that covers the task, a part is shortened when the segments before it already cover the rest of the task. Like a
+// resumed segment, a part after the first includes the setup time in its duration. The assignment is empty if a part has no matching
+// segment or does not fit into the time window of its segment.
+vector<int32_t> SAT_encoder::create_warm_start_assignment(Heuristic_Solver::Solution& solution)
+{
+	vector<vector<pair<int, int>>> task_parts(parsed_tasks.size()); // start time, duration
+	for (int i = 0; i < solution.task_ids.size(); i++)
+	{
+		task_parts[task_graph.task_index[solution.task_ids[i]]].push_back(pair<int, int>(solution.start_times[i], solution.durations[i]));
+	}
 
-			destruction_split_ids.push_back(vector<vector<int>> {vector<int>{to_be_destroyed.split_task_id}, vector<int>{to_be_destroyed_begin.split_task_id, to_be_destroyed_end.split_task_id}});
-		}
+	map<tuple<int, int, int>, int> segment_indices; // parsed task index, segment and duration -> index in preempted_tasks
+	for (int i = 1; i < preempted_tasks.size() - 1; i++)
+	{
+		segment_indices[make_tuple(task_graph.task_index[preempted_tasks[i].id], preempted_tasks[i].segment, preempted_tasks[i].duration)] = i;
 	}
 
-	vector<Task> remaining_tasks = new_task_list;
-	vector<vector<vector<Task>>> destroyed_tasks;
-	for (int i = 0; i < destruction_split_ids.size(); i++)
+	vector<int> start_times(preempted_tasks.size(), -1);
+	for (int task = 1; task < parsed_tasks.size() - 1; task++)
 	{
-		vector<vector<Task>> destroyed_task;
-		for (int j = 0; j < destruction_split_ids[i].size(); j++)
+		sort(task_parts[task].begin(), task_parts[task].end());
+		int segment = 1;
+		for (pair<int, int>& task_part : task_parts[task])
 		{
-			vector<Task> destroyed_task_parts;
-			for (int k = 0; k < destruction_split_ids[i][j].size(); k++)
-			{
-				Task destroyed_task_part;
-				for (int l = 0; l < remaining_tasks.size(); l++)
-				{
-					if (remaining_tasks[l].split_task_id == destruction_split_ids[i][j][k])
-					{
-						destroyed_task_part = remaining_tasks[l];
-						remaining_tasks.erase(remaining_tasks.begin() + l);
-					}
-				}
-				destroyed_task_parts.push_back(destroyed_task_part);
+			if (segment > parsed_tasks[task].duration) {
+				break;
+			}
+			int part_setup_time = segment > 1 ? segment_setup_time : 0;
+			int units = min(task_part.second - part_setup_time, parsed_tasks[task].duration + 1 - segment);
+			int duration = units + part_setup_time;
+
+			auto segment_index_iterator = segment_indices.find(make_tuple(task, segment, duration));
+			if (segment_index_iterator == segment_indices.end()) {
+				return vector<int32_t>();
+			}
+			int segment_index = segment_index_iterator->second;
+			if (task_part.first < preempted_tasks[segment_index].early_start || task_part.first > preempted_tasks[segment_index].late_finish - duration) {
+				return vector<int32_t>();
 			}
-			destroyed_task.push_back(destroyed_task_parts);
+
+			start_times[segment_index] = task_part.first;
+			segment += units;
+		}
+		if (segment <= parsed_tasks[task].duration) {
+			return vector<int32_t>();
 		}
-		destroyed_tasks.push_back(destroyed_task);
 	}
 
-	vector<int> cleanup_task_ids;
+	// The finish is started at every time from the makespan on, as in the optimal assignment of the objective
+	Task& finish = preempted_tasks.back();
+	if (solution.makespan < finish.early_start || solution.makespan > finish.late_finish) {
+		return vector<int32_t>();
+	}
 
-	while (destroyed_tasks.size() > 0)
+	vector<vector<bool>> aggregates_processed(parsed_tasks.size());
+	for (int task = 0; task < parsed_tasks.size(); task++)
 	{
-		vector<vector<Task>> destroyed_task = destroyed_tasks[0];
-		destroyed_tasks.erase(destroyed_tasks.begin());
-
-		pair<int, vector<Task>> best_possible_task_list = pair<int, vector<Task>>{ horizon, vector<Task>{} };
-		vector<int> previous_best_parts;
+		aggregates_processed[task] = vector<bool>(parsed_tasks[task].process_aggregate_variables.size(), false);
+	}
 
-		for (int i = 0; i < destroyed_task.size(); i++)
+	vector<int32_t> assignment;
+	for (int i = 1; i < preempted_tasks.size(); i++)
+	{
+		Task& task = preempted_tasks[i];
+		for (int j = 0; j < task.start_variables.size(); j++)
 		{
-			vector<Task> possible_task_list = remaining_tasks;
-			for (int j = 0; j < destroyed_task[i].size(); j++)
-			{
-				int minimum_makespan = horizon;
-				int optimal_insertion_index = -1;
-				for (int k = 0; k < possible_task_list.size(); k++)
-				{
-					possible_task_list.insert(possible_task_list.begin() + k, destroyed_task[i][j]);
-					vector<int>tmp(2);
-					vector<Task> successor_test_list = possible_task_list;
-					for (vector<vector<Task>> destroyed_task : destroyed_tasks) {
-						vector<Task> flattened = flatten(destroyed_task);
-						successor_test_list.insert(successor_test_list.end(), flattened.begin(), flattened.end());
-					}
-					if (!check_presedence_violation(possible_task_list, tmp, successor_test_list)) {
-						int makespan_test = calculate_makespan(possible_task_list, job_id.get_max_id());
-						if (makespan_test < minimum_makespan) {
-							minimum_makespan = makespan_test;
-							optimal_insertion_index = k;
-						}
-					}
-					possible_task_list.erase(possible_task_list.begin() + k);
-				}
-				assert(optimal_insertion_index >= 0);
-				possible_task_list.insert(possible_task_list.begin() + optimal_insertion_index, destroyed_task[i][j]);
-			}
-			int possible_task_list_makespan = calculate_makespan(possible_task_list, job_id.get_max_id());
-			if (possible_task_list_makespan < best_possible_task_list.first) {
-				best_possible_task_list = pair<int, vector<Task>>{ possible_task_list_makespan , possible_task_list };
-				for (int j = 0; j < previous_best_parts.size(); j++)
-				{
-					cleanup_task_ids.push_back(previous_best_parts[j]);
-				}
-				previous_best_parts = vector<int>{};
-				for (int j = 0; j < destroyed_task[i].size(); j++)
-				{
-					previous_best_parts.push_back(destroyed_task[i][j].split_task_id);
-				}
+			bool started = i == preempted_tasks.size() - 1 ? task.early_start + j >= solution.makespan : task.early_start + j == start_times[i];
+			assignment.push_back(started ? task.start_variables[j] : -task.start_variables[j]);
+		}
+		for (int j = 0; j < task.process_variables.size(); j++)
+		{
+			bool processed = start_times[i] >= 0 && task.early_start + j >= start_times[i] && task.early_start + j < start_times[i] + task.duration;
+			assignment.push_back(processed ? task.process_variables[j] : -task.process_variables[j]);
+			if (processed && use_process_aggregates) {
+				int task_index = task_graph.task_index[task.id];
+				aggregates_processed[task_index][task.early_start + j - parsed_tasks[task_index].early_start] = true;
 			}
-			else {
-				for (int j = 0; j < destroyed_task[i].size(); j++)
-				{
-					cleanup_task_ids.push_back(destroyed_task[i][j].split_task_id);
-				}
+		}
+		for (int j = 0; j < task.order_variables.size(); j++)
+		{
+			bool started = start_times[i] >= 0 && task.early_start + j >= start_times[i];
+			assignment.push_back(started ? task.order_variables[j] : -task.order_variables[j]);
+		}
+	}
+	for (int task = 0; task < parsed_tasks.size(); task++)
+	{
+		for (int j = 0; j < parsed_tasks[task].process_aggregate_variables.size(); j++)
+		{
+			int32_t variable = parsed_tasks[task].process_aggregate_variables[j];
+			if (variable != 0) {
+				assignment.push_back(aggregates_processed[task][j] ? variable : -variable);
 			}
 		}
-		assert(best_possible_task_list.first < horizon);
-		remaining_tasks = best_possible_task_list.second;
 	}
+	return assignment;
+}
 
-	int makespan_test = calculate_makespan(remaining_tasks, job_id.get_max_id());
-
-	if (makespan_test < makespan)
+// Orders the parsed tasks by the first time any of their segments is started in the given solution, the values are indexed
+// by the CNF variable
+vector<int> SAT_encoder::decode_task_order(const vector<bool>& variable_values)
+{
+	vector<int> start_times(parsed_tasks.size(), INT_MAX);
+	for (int i = 1; i < preempted_tasks.size() - 1; i++)
 	{
-		for (int i = 0; i < cleanup_task_ids.size(); i++)
+		Task& task = preempted_tasks[i];
+		for (int j = 0; j < task.start_variables.size(); j++)
 		{
-			int cleanup_task_id = cleanup_task_ids[i];
-			for (int j = 0; j < remaining_tasks.size(); j++)
-			{
-				remaining_tasks[j].successors.erase(remove_if(remaining_tasks[j].successors.begin(), remaining_tasks[j].successors.end(), [&cleanup_task_id](int successor) {return successor == cleanup_task_id; }), remaining_tasks[j].successors.end());
+			if (task.start_variables[j] < variable_values.size() && variable_values[task.start_variables[j]]) {
+				start_times[task.id] = min(start_times[task.id], task.early_start + j);
+				break;
 			}
 		}
-		task_list = remaining_tasks;
-		return makespan_test;
 	}
 
-	return makespan;
+	vector<int> task_order(parsed_tasks.size());
+	for (int i = 0; i < task_order.size(); i++)
+	{
+		task_order[i] = i;
+	}
+	sort(task_order.begin() + 1, task_order.end() - 1, [&start_times](int lhs, int rhs) {return start_times[lhs] < start_times[rhs] || (start_times[lhs] == start_times[rhs] && lhs < rhs); });
+	return task_order;
 }
 
-string SAT_encoder::encode(string project_lib_folder, string project_lib_file, int setup_time)
+void SAT_encoder::prepare_encoding(string project_lib_folder, string project_lib_file, int setup_time)
 {
 #pragma region setup
+	int greedy_upper_bound_makespan = compute_time_windows(project_lib_folder, project_lib_file);
+	preempt_tasks(setup_time);
+
+	if (heuristic_upper_bound != INT_MAX) {
+		report_horizon_reduction(greedy_upper_bound_makespan);
+	}
+	if (use_segment_pruning) {
+		prune_segments(preempted_tasks);
+	}
+
+	set_start_variables();
+	set_process_variables();
+	if (use_process_aggregates) {
+		set_process_aggregate_variables();
+	}
+	if (use_order_encoding) {
+		set_order_variables();
+	}
+#pragma endregion
+}
+
+// Parses the instance and sets the time windows of the parsed tasks within the upper bound, returns the greedy upper bound
+int SAT_encoder::compute_time_windows(string project_lib_folder, string project_lib_file)
+{
 	parse_input_file(project_lib_folder + project_lib_file);
+	build_task_graph();
 
 #pragma region upper bound
 	vector<Task> upper_bound_task_list = parsed_tasks;
@@ -562,26 +1666,16 @@ string SAT_encoder::encode(string project_lib_folder, string project_lib_file, i
 
 	construct_upper_bound_task_list(upper_bound_task_list);
 	upper_bound_makespan = calculate_sgs_makespan(upper_bound_task_list);
-#pragma endregion
-
-	critical_path();
-	preempt_tasks(setup_time);
-
-	set_start_variables();
-	set_process_variables();
-
-	vector<Task> reduced_preempted_tasks = preempted_tasks;
-	remove_duplicate_segments(reduced_preempted_tasks);
-#pragma endregion
 
-#pragma region CNF encoding
-	write_cnf_file(preempted_tasks, project_lib_file);
+	int greedy_upper_bound_makespan = upper_bound_makespan;
+	upper_bound_makespan = min(upper_bound_makespan, heuristic_upper_bound);
 #pragma endregion
 
-
-	Task back_task = preempted_tasks.back();
-
-	return string();
+	critical_path();
+	if (use_energetic_windows) {
+		tighten_time_windows();
+	}
+	return greedy_upper_bound_makespan;
 }
 
 void SAT_encoder::parse_input_file(string filename)
@@ -635,74 +1729,345 @@ void SAT_encoder::parse_input_file(string filename)
 	project_lib.close();
 }
 
+void SAT_encoder::build_task_graph()
+{
+	int task_count = parsed_tasks.size();
+
+	int max_task_id = 0;
+	for (Task& task : parsed_tasks)
+	{
+		max_task_id = max(max_task_id, task.id);
+	}
+	task_graph.task_index = vector<int>(max_task_id + 1, -1);
+	for (int i = 0; i < task_count; i++)
+	{
+		task_graph.task_index[parsed_tasks[i].id] = i;
+	}
+
+	vector<int> predecessor_counts(task_count, 0);
+	task_graph.successor_offsets = vector<int>(task_count + 1, 0);
+	task_graph.successor_indices.clear();
+	for (int i = 0; i < task_count; i++)
+	{
+		for (pair<int, int> successor : parsed_tasks[i].successors)
+		{
+			int successor_index = task_graph.task_index[successor.first];
+			task_graph.successor_indices.push_back(successor_index);
+			predecessor_counts[successor_index]++;
+		}
+		task_graph.successor_offsets[i + 1] = task_graph.successor_indices.size();
+	}
+
+	task_graph.predecessor_offsets = vector<int>(task_count + 1, 0);
+	for (int i = 0; i < task_count; i++)
+	{
+		task_graph.predecessor_offsets[i + 1] = task_graph.predecessor_offsets[i] + predecessor_counts[i];
+	}
+	task_graph.predecessor_indices = vector<int>(task_graph.successor_indices.size());
+	vector<int> next_predecessor_slot(task_graph.predecessor_offsets.begin(), task_graph.predecessor_offsets.end() - 1);
+	for (int i = 0; i < task_count; i++)
+	{
+		for (int k = task_graph.successor_offsets[i]; k < task_graph.successor_offsets[i + 1]; k++)
+		{
+			task_graph.predecessor_indices[next_predecessor_slot[task_graph.successor_indices[k]]++] = i;
+		}
+	}
+
+	// Kahn's algorithm
+	task_graph.topological_order.clear();
+	vector<int> remaining_predecessors = predecessor_counts;
+	for (int i = 0; i < task_count; i++)
+	{
+		if (remaining_predecessors[i] == 0) {
+			task_graph.topological_order.push_back(i);
+		}
+	}
+	for (int k = 0; k < task_graph.topological_order.size(); k++)
+	{
+		int task = task_graph.topological_order[k];
+		for (int l = task_graph.successor_offsets[task]; l < task_graph.successor_offsets[task + 1]; l++)
+		{
+			int successor = task_graph.successor_indices[l];
+			if (--remaining_predecessors[successor] == 0) {
+				task_graph.topological_order.push_back(successor);
+			}
+		}
+	}
+	if (task_graph.topological_order.size() != task_count) {
+		throw runtime_error("precedence graph contains a cycle");
+	}
+
+	// Adding the edges in reverse topological order only extends the closure of the source of each edge
+	task_graph.reachability = Reachability_index();
+	for (int i = 0; i < task_count; i++)
+	{
+		task_graph.reachability.add_node();
+	}
+	for (int k = task_count - 1; k >= 0; k--)
+	{
+		int task = task_graph.topological_order[k];
+		for (int l = task_graph.successor_offsets[task]; l < task_graph.successor_offsets[task + 1]; l++)
+		{
+			task_graph.reachability.add_edge(task, task_graph.successor_indices[l]);
+		}
+	}
+}
+
 void SAT_encoder::critical_path()
 {
-	parsed_tasks[0].early_start = 0;
-	parsed_tasks[0].early_finish = -1;
-	for (int j = 0; j < parsed_tasks[0].successors.size(); j++)
+	int task_count = parsed_tasks.size();
+	int source = 0;
+	int sink = task_count - 1;
+
+	// Forward sweep: a task starts after the latest finish of its predecessors, only tasks reachable from the source are updated
+	vector<bool> reached(task_count, false);
+	parsed_tasks[source].early_start = 0;
+	parsed_tasks[source].early_finish = -1;
+	reached[source] = true;
+	for (int task : task_graph.topological_order)
 	{
-		forward_pass(parsed_tasks[0].successors[j], 0);
+		if (task == source)
+		{
+			continue;
+		}
+		for (int k = task_graph.predecessor_offsets[task]; k < task_graph.predecessor_offsets[task + 1]; k++)
+		{
+			int predecessor = task_graph.predecessor_indices[k];
+			if (!reached[predecessor])
+			{
+				continue;
+			}
+			int early_start = predecessor == source ? 0 : parsed_tasks[predecessor].early_finish;
+			if (early_start > parsed_tasks[task].early_start) {
+				parsed_tasks[task].early_start = early_start;
+				parsed_tasks[task].early_finish = early_start + parsed_tasks[task].duration;
+			}
+			reached[task] = true;
+		}
 	}
 
-	parsed_tasks.back().late_start = upper_bound_makespan + 1;
-	parsed_tasks.back().late_finish = upper_bound_makespan;
-	for (int j = 0; j < parsed_tasks.size(); j++)
+	// Backward sweep: a task finishes before the earliest start of its successors, only tasks that reach the sink are updated
+	reached = vector<bool>(task_count, false);
+	parsed_tasks[sink].late_start = upper_bound_makespan + 1;
+	parsed_tasks[sink].late_finish = upper_bound_makespan;
+	reached[sink] = true;
+	for (int k = task_count - 1; k >= 0; k--)
 	{
-		for (int k = 0; k < parsed_tasks[j].successors.size(); k++)
+		int task = task_graph.topological_order[k];
+		if (task == sink)
+		{
+			continue;
+		}
+		for (int l = task_graph.successor_offsets[task]; l < task_graph.successor_offsets[task + 1]; l++)
 		{
-			if (parsed_tasks[j].successors[k].first == parsed_tasks.back().id && parsed_tasks[j].successors[k].second == parsed_tasks.back().segment)
+			int successor = task_graph.successor_indices[l];
+			if (!reached[successor])
 			{
-				backward_pass(pair<int, int>(parsed_tasks[j].id, parsed_tasks[j].segment), upper_bound_makespan);
+				continue;
+			}
+			int late_finish = successor == sink ? upper_bound_makespan : parsed_tasks[successor].late_start;
+			if (late_finish < parsed_tasks[task].late_finish) {
+				parsed_tasks[task].late_finish = late_finish;
+				parsed_tasks[task].late_start = late_finish - parsed_tasks[task].duration;
+			}
+			reached[task] = true;
+		}
+	}
+}
+
+// Narrows the time windows of critical_path by energetic reasoning until neither of the rules below changes a window. Preemption
+// and setup times only add to the time the tasks need, so the windows stay valid for every segment, and the resource lower bound on
+// the makespan follows as the earliest start of the sink.
+void SAT_encoder::tighten_time_windows()
+{
+	bool changed = true;
+	while (changed) {
+		changed = tighten_by_precedence_energy();
+		changed = tighten_by_interval_energy() || changed;
+
+		for (Task& task : parsed_tasks)
+		{
+			if (task.early_finish > task.late_finish) {
+				throw runtime_error("time windows are inconsistent with the upper bound");
 			}
 		}
 	}
 }
 
-void SAT_encoder::forward_pass(pair<int, int> task_segment_id, int early_start)
+// Every ancestor of a task is processed completely before the task starts, so the ancestors that are released at or after time T
+// need at least their total energy on a resource divided by its capacity after T. Likewise the descendants have to fit between the
+// finish of the task and the latest finish of the earliest of them.
+bool SAT_encoder::tighten_by_precedence_energy()
 {
-	for (int i = 0; i < parsed_tasks.size(); i++)
+	int task_count = parsed_tasks.size();
+	int source = 0;
+	int sink = task_count - 1;
+	bool changed = false;
+
+	for (int task : task_graph.topological_order)
 	{
-		if (parsed_tasks[i].id == task_segment_id.first && parsed_tasks[i].segment == task_segment_id.second)
+		if (task == source)
 		{
-			if (early_start > parsed_tasks[i].early_start) {
-				parsed_tasks[i].early_start = early_start;
-				parsed_tasks[i].early_finish = early_start + parsed_tasks[i].duration;
-				for (int j = 0; j < parsed_tasks[i].successors.size(); j++)
-				{
-					forward_pass(parsed_tasks[i].successors[j], parsed_tasks[i].early_finish);
-				}
+			continue;
+		}
+		int early_start = parsed_tasks[task].early_start;
+		for (int k = task_graph.predecessor_offsets[task]; k < task_graph.predecessor_offsets[task + 1]; k++)
+		{
+			int predecessor = task_graph.predecessor_indices[k];
+			early_start = max(early_start, predecessor == source ? 0 : parsed_tasks[predecessor].early_finish);
+		}
+
+		vector<int> ancestors = collect_connected_tasks(task, task_graph.predecessor_offsets, task_graph.predecessor_indices);
+		sort(ancestors.begin(), ancestors.end(), [this](int lhs, int rhs) {return parsed_tasks[lhs].early_start > parsed_tasks[rhs].early_start; });
+		for (int i = 0; i < resource_availabilities.size(); i++)
+		{
+			long long energy = 0;
+			for (int ancestor : ancestors)
+			{
+				energy += (long long)parsed_tasks[ancestor].duration * parsed_tasks[ancestor].resource_requirements[i];
+				int ancestor_start = ancestor == source ? 0 : parsed_tasks[ancestor].early_start;
+				early_start = max(early_start, ancestor_start + (int)((energy + resource_availabilities[i] - 1) / resource_availabilities[i]));
+			}
+		}
+
+		if (early_start > parsed_tasks[task].early_start) {
+			parsed_tasks[task].early_start = early_start;
+			changed = true;
+		}
+		parsed_tasks[task].early_finish = max(parsed_tasks[task].early_finish, early_start + parsed_tasks[task].duration);
+	}
+
+	for (int k = task_count - 1; k >= 0; k--)
+	{
+		int task = task_graph.topological_order[k];
+		if (task == sink)
+		{
+			continue;
+		}
+		int late_finish = parsed_tasks[task].late_finish;
+		for (int l = task_graph.successor_offsets[task]; l < task_graph.successor_offsets[task + 1]; l++)
+		{
+			int successor = task_graph.successor_indices[l];
+			late_finish = min(late_finish, successor == sink ? upper_bound_makespan : parsed_tasks[successor].late_start);
+		}
+
+		vector<int> descendants = collect_connected_tasks(task, task_graph.successor_offsets, task_graph.successor_indices);
+		sort(descendants.begin(), descendants.end(), [this](int lhs, int rhs) {return parsed_tasks[lhs].late_finish < parsed_tasks[rhs].late_finish; });
+		for (int i = 0; i < resource_availabilities.size(); i++)
+		{
+			long long energy = 0;
+			for (int descendant : descendants)
+			{
+				energy += (long long)parsed_tasks[descendant].duration * parsed_tasks[descendant].resource_requirements[i];
+				int descendant_finish = descendant == sink ? upper_bound_makespan : parsed_tasks[descendant].late_finish;
+				late_finish = min(late_finish, descendant_finish - (int)((energy + resource_availabilities[i] - 1) / resource_availabilities[i]));
 			}
 		}
+
+		if (late_finish < parsed_tasks[task].late_finish) {
+			parsed_tasks[task].late_finish = late_finish;
+			changed = true;
+		}
+		parsed_tasks[task].late_start = min(parsed_tasks[task].late_start, late_finish - parsed_tasks[task].duration);
 	}
+
+	return changed;
 }
 
-void SAT_encoder::backward_pass(pair<int, int> task_segment_id, int late_finish)
+// Energetic reasoning on the intervals between the earliest starts and latest finishes: a task processes at least
+// duration - (a - early start) - (late finish - b) units in [a, b) in any preemptive schedule. The capacity left in [a, b) by the
+// other tasks limits how much of a task fits into the interval, the rest has to be processed after b, which raises its earliest
+// finish, or before a, which lowers its latest start. Both only move the windows of the successors and predecessors.
+bool SAT_encoder::tighten_by_interval_energy()
 {
-	for (int i = 0; i < parsed_tasks.size(); i++)
+	int task_count = parsed_tasks.size();
+	bool changed = false;
+
+	vector<int> interval_starts;
+	vector<int> interval_ends;
+	for (int task = 1; task < task_count - 1; task++)
+	{
+		interval_starts.push_back(parsed_tasks[task].early_start);
+		interval_ends.push_back(parsed_tasks[task].late_finish);
+	}
+	sort(interval_starts.begin(), interval_starts.end());
+	interval_starts.erase(unique(interval_starts.begin(), interval_starts.end()), interval_starts.end());
+	sort(interval_ends.begin(), interval_ends.end());
+	interval_ends.erase(unique(interval_ends.begin(), interval_ends.end()), interval_ends.end());
+
+	vector<int> minimal_intersections(task_count);
+	for (int i = 0; i < resource_availabilities.size(); i++)
 	{
-		if (parsed_tasks[i].id == task_segment_id.first && parsed_tasks[i].segment == task_segment_id.second)
+		for (int a : interval_starts)
 		{
-			if (late_finish < parsed_tasks[i].late_finish) {
-				parsed_tasks[i].late_finish = late_finish;
-				parsed_tasks[i].late_start = late_finish - parsed_tasks[i].duration;
+			for (int b : interval_ends)
+			{
+				if (b <= a) {
+					continue;
+				}
 
-				for (int j = 0; j < parsed_tasks.size(); j++)
+				long long energy = 0;
+				for (int task = 1; task < task_count - 1; task++)
 				{
-					for (int k = 0; k < parsed_tasks[j].successors.size(); k++)
-					{
-						if (parsed_tasks[j].successors[k].first == task_segment_id.first && parsed_tasks[j].successors[k].second == task_segment_id.second)
-						{
-							backward_pass(pair<int, int>(parsed_tasks[j].id, parsed_tasks[j].segment), parsed_tasks[i].late_start);
-						}
+					Task& current = parsed_tasks[task];
+					minimal_intersections[task] = max(0, current.duration - max(0, a - current.early_start) - max(0, current.late_finish - b));
+					energy += (long long)minimal_intersections[task] * current.resource_requirements[i];
+				}
+
+				for (int task = 1; task < task_count - 1; task++)
+				{
+					Task& current = parsed_tasks[task];
+					int requirement = current.resource_requirements[i];
+					if (requirement == 0) {
+						continue;
+					}
+					long long free_energy = (long long)resource_availabilities[i] * (b - a) - (energy - (long long)minimal_intersections[task] * requirement);
+					int units_in_interval = (int)min((long long)(b - a), max(0LL, free_energy / requirement));
+
+					int units_after = current.duration - min(current.duration, max(0, a - current.early_start)) - units_in_interval;
+					if (units_after > 0 && b + units_after > current.early_finish) {
+						current.early_finish = b + units_after;
+						changed = true;
+					}
+					int units_before = current.duration - min(current.duration, max(0, current.late_finish - b)) - units_in_interval;
+					if (units_before > 0 && a - units_before < current.late_start) {
+						current.late_start = a - units_before;
+						changed = true;
 					}
 				}
 			}
 		}
 	}
+
+	return changed;
+}
+
+// All tasks reachable from the given task over the edges in indices[offsets[i] .. offsets[i + 1]), excluding the task itself
+vector<int> SAT_encoder::collect_connected_tasks(int task, vector<int>& offsets, vector<int>& indices)
+{
+	vector<bool> visited(parsed_tasks.size(), false);
+	vector<int> connected_tasks;
+	vector<int> stack{ task };
+	while (!stack.empty())
+	{
+		int current = stack.back();
+		stack.pop_back();
+		for (int k = offsets[current]; k < offsets[current + 1]; k++)
+		{
+			int next = indices[k];
+			if (!visited[next]) {
+				visited[next] = true;
+				connected_tasks.push_back(next);
+				stack.push_back(next);
+			}
+		}
+	}
+	return connected_tasks;
 }
 
 void SAT_encoder::preempt_tasks(int setup_time)
 {
+	segment_setup_time = setup_time;
 	preempted_tasks.push_back(parsed_tasks.front());
 	for (Task parsed_task : parsed_tasks)
 	{
@@ -711,6 +2076,8 @@ void SAT_encoder::preempt_tasks(int setup_time)
 	preempted_tasks.push_back(parsed_tasks.back());
 }
 
+// Creates a segment for every first unit i and number of units j of the task. A resumed segment (i > 1) takes the setup time
+// before its j units, the next segment of the chain starts at unit i + j.
 void SAT_encoder::preempt_task(Task task, int setup_time)
 {
 	for (int i = 1; i <= task.duration; i++)
@@ -719,15 +2086,17 @@ void SAT_encoder::preempt_task(Task task, int setup_time)
 		{
 			Task task_part = task;
 			task_part.segment = i;
-			task_part.duration = task_part.segment > 1 ? j + setup_time : j;
+			task_part.setup_time = task_part.segment > 1 ? setup_time : 0;
+			task_part.duration = j + task_part.setup_time;
 			if (task_part.segment > 1) {
 				task_part.early_start += (i - 1);
 			}
-			if (task_part.segment + task_part.duration - 1 < task.duration) {
-				task_part.late_finish -= (task.duration - task_part.segment - task_part.duration + 1 + setup_time);
+			// The remaining units follow in resumed segments
+			if (i + j - 1 < task.duration) {
+				task_part.late_finish -= (task.duration - i - j + 1 + setup_time);
 			}
-			if (task_part.segment + task_part.duration != task.segment + task.duration) {
-				task_part.successors = vector<pair<int, int>>{ pair<int, int>(task.id, task_part.segment + task_part.duration) };
+			if (i + j != task.segment + task.duration) {
+				task_part.successors = vector<pair<int, int>>{ pair<int, int>(task.id, i + j) };
 			}
 			preempted_tasks.push_back(task_part);
 		}
@@ -756,31 +2125,126 @@ void SAT_encoder::set_process_variables()
 	}
 }
 
-void SAT_encoder::remove_duplicate_segments(vector<Task>& task_list)
+// Number of start and process variables if the late finish of every segment moved by the given shift, as it does when the upper
+// bound moves by that amount
+long long SAT_encoder::count_time_indexed_variables(int late_finish_shift)
+{
+	long long variable_count = 0;
+	for (int i = 1; i < preempted_tasks.size(); i++)
+	{
+		Task& task = preempted_tasks[i];
+		variable_count += max(0, task.late_finish + late_finish_shift - task.duration - task.early_start + 1);
+		if (i < preempted_tasks.size() - 1) {
+			variable_count += max(0, task.late_finish + late_finish_shift - task.early_start + 1);
+		}
+	}
+	return variable_count;
+}
+
+// Writes how much smaller the encoding becomes with the heuristic upper bound than with the greedy one to stderr, the resource
+// constraints are counted instead of their clauses since their encodings depend on the tasks at each time
+void SAT_encoder::report_horizon_reduction(int greedy_upper_bound_makespan)
+{
+	int shift = greedy_upper_bound_makespan - upper_bound_makespan;
+	long long resource_constraint_count = (long long)resource_availabilities.size() * (upper_bound_makespan + 1);
+	cerr << "horizon: " << greedy_upper_bound_makespan << " -> " << upper_bound_makespan << '\n';
+	cerr << "start and process variables: " << count_time_indexed_variables(shift) << " -> " << count_time_indexed_variables(0) << '\n';
+	cerr << "resource constraints: " << resource_constraint_count + (long long)resource_availabilities.size() * shift << " -> " << resource_constraint_count << '\n';
+}
+
+// One variable per parsed task and time at which at least one of its segments has a process variable, allocated after all process
+// variables in order of the tasks and times
+void SAT_encoder::set_process_aggregate_variables()
+{
+	for (int i = 1; i < preempted_tasks.size() - 1; i++)
+	{
+		Task& segment = preempted_tasks[i];
+		Task& task = parsed_tasks[task_graph.task_index[segment.id]];
+		if (task.process_aggregate_variables.empty()) {
+			task.process_aggregate_variables = vector<int32_t>(task.late_finish - task.early_start + 1, 0);
+		}
+		for (int j = 0; j < segment.process_variables.size(); j++)
+		{
+			task.process_aggregate_variables[segment.early_start + j - task.early_start] = -1;
+		}
+	}
+
+	for (Task& task : parsed_tasks)
+	{
+		for (int32_t& variable : task.process_aggregate_variables)
+		{
+			if (variable != 0) {
+				variable = cnf_variable.get_variable();
+			}
+		}
+	}
+}
+
+void SAT_encoder::set_order_variables()
+{
+	for (int i = 1; i < preempted_tasks.size() - 1; i++)
+	{
+		for (int j = 0; j < preempted_tasks[i].start_variables.size(); j++)
+		{
+			preempted_tasks[i].order_variables.push_back(cnf_variable.get_variable());
+		}
+	}
+}
+
+// Removes the segments that are not on a chain of segments from the first unit of their task to a segment that finishes it, where
+// every segment on the chain has a non-empty start window. A solution can drop the other segments: every started segment needs a
+// chain of started segments back to the first unit, the successors of a task wait for a finishing segment, and no constraint
+// requires a segment to be followed. The segments of a task are consecutive in the list, so the pruning is linear in the number of
+// segments.
+void SAT_encoder::prune_segments(vector<Task>& task_list)
 {
-	int i = 0;
-	while (i < task_list.size())
+	vector<bool> keep(task_list.size(), true);
+	int first = 1;
+	while (first < task_list.size() - 1)
 	{
-		bool removed_segment = false;
-		int j = i + 1;
-		while (j < task_list.size())
+		int last = first;
+		while (last + 1 < task_list.size() - 1 && task_list[last + 1].id == task_list[first].id)
+		{
+			last++;
+		}
+
+		int end_segment = parsed_tasks[task_graph.task_index[task_list[first].id]].duration + 1;
+		vector<bool> reachable(end_segment + 1, false); // a chain from the first unit reaches the segment
+		vector<bool> finishable(end_segment + 1, false); // a chain from the segment finishes the task
+		reachable[1] = true;
+		finishable[end_segment] = true;
+		for (int i = first; i <= last; i++)
 		{
-			if (task_list[j].id == task_list[i].id &&
-				task_list[j].segment >= task_list[i].segment &&
-				task_list[j].segment < task_list[i].segment + task_list[i].duration)
-			{
-				task_list.erase(task_list.begin() + j);
-				removed_segment = true;
+			keep[i] = task_list[i].late_finish - task_list[i].duration >= task_list[i].early_start;
+		}
+		// The segments are generated in increasing order of their first unit
+		for (int i = first; i <= last; i++)
+		{
+			int next_segment = task_list[i].segment + task_list[i].duration - task_list[i].setup_time;
+			if (keep[i] && reachable[task_list[i].segment] && next_segment <= end_segment) {
+				reachable[next_segment] = true;
 			}
-			j++;
 		}
-		if (removed_segment) {
-			i = 0;
+		for (int i = last; i >= first; i--)
+		{
+			int next_segment = task_list[i].segment + task_list[i].duration - task_list[i].setup_time;
+			keep[i] = keep[i] && reachable[task_list[i].segment] && next_segment <= end_segment && finishable[next_segment];
+			if (keep[i]) {
+				finishable[task_list[i].segment] = true;
+			}
 		}
-		else {
-			i++;
+
+		first = last + 1;
+	}
+
+	int kept_count = 0;
+	for (int i = 0; i < task_list.size(); i++)
+	{
+		if (keep[i]) {
+			task_list[kept_count++] = task_list[i];
 		}
 	}
+	task_list.resize(kept_count);
 }
 
 void SAT_encoder::calculate_rurs(vector<Task>& task_list)
@@ -809,31 +2273,37 @@ void SAT_encoder::fix_presedence_constraint(vector<Task>& task_list)
 
 bool SAT_encoder::check_presedence_violation(vector<Task>& task_list, vector<int>& task_in_violation_at_index)
 {
+	vector<uint64_t> preceding_tasks = task_graph.reachability.create_node_set();
+	Reachability_index::insert(preceding_tasks, task_graph.task_index[task_list[0].id]);
 	for (int i = 1; i < task_list.size(); i++)
 	{
+		int node = task_graph.task_index[task_list[i].id];
+		if (!task_graph.reachability.reaches_any(node, preceding_tasks)) {
+			Reachability_index::insert(preceding_tasks, node);
+			continue;
+		}
+
+		// The violated successor is the first preceding task found when exploring the successors breadth first
 		vector<pair<int, int>> successors = task_list[i].successors;
-		while (successors.size() > 0)
+		vector<bool> explored(parsed_tasks.size(), false);
+		for (int k = 0; k < successors.size(); k++)
 		{
-			pair<int, int> successor = successors[0];
-			successors.erase(successors.begin());
+			int successor = task_graph.task_index[successors[k].first];
+			if (explored[successor])
+			{
+				continue;
+			}
+			explored[successor] = true;
 			for (int j = 0; j < i; j++)
 			{
-				if (task_list[j].id == successor.first) {
+				if (task_list[j].id == successors[k].first) {
 					task_in_violation_at_index = { i,j };
 					return true;
 				}
 			}
-			for (int j = 0; j < parsed_tasks.size(); j++)
-			{
-				if (parsed_tasks[j].id == successor.first) {
-					for (int k = 0; k < parsed_tasks[j].successors.size(); k++)
-					{
-						successors.push_back(parsed_tasks[j].successors[k]);
-					}
-					break;
-				}
-			}
+			successors.insert(successors.end(), parsed_tasks[successor].successors.begin(), parsed_tasks[successor].successors.end());
 		}
+		throw runtime_error("reachability index is inconsistent with the task successors");
 	}
 
 	return false;
@@ -856,6 +2326,21 @@ bool SAT_encoder::check_presedence_violation(vector<Task>& task_list, vector<int
 	return false;*/
 }
 
+bool SAT_encoder::has_presedence_violation(vector<Task>& task_list)
+{
+	vector<uint64_t> preceding_tasks = task_graph.reachability.create_node_set();
+	for (int i = 0; i < task_list.size(); i++)
+	{
+		int node = task_graph.task_index[task_list[i].id];
+		if (task_graph.reachability.reaches_any(node, preceding_tasks)) {
+			return true;
+		}
+		Reachability_index::insert(preceding_tasks, node);
+	}
+
+	return false;
+}
+
 // Found on StackOverflow answer: https://stackoverflow.com/a/57399634
 template <typename t> void SAT_encoder::move(vector<t>& v, size_t oldIndex, size_t newIndex)
 {
@@ -893,8 +2378,7 @@ void SAT_encoder::construct_upper_bound_task_list(vector<Task>& task_list)
 		for (int i = 0; i <= new_task_list.size(); i++)
 		{
 			new_task_list.insert(new_task_list.begin() + i, to_schedule_task);
-			vector<int>tmp(2);
-			if (!check_presedence_violation(new_task_list, tmp)) {
+			if (!has_presedence_violation(new_task_list)) {
 				int makespan_test = calculate_sgs_makespan(new_task_list);
 				if (makespan_test < minimum_makespan) {
 					minimum_makespan = makespan_test;
@@ -912,11 +2396,7 @@ void SAT_encoder::construct_upper_bound_task_list(vector<Task>& task_list)
 
 int SAT_encoder::calculate_sgs_makespan(vector<Task>& task_list)
 {
-	vector<vector<int>> remaining_resources;
-	for (int i = 0; i < horizon; i++)
-	{
-		remaining_resources.push_back(resource_availabilities);
-	}
+	resource_profile.reset(horizon, resource_availabilities);
 
 	for (int i = 0; i < task_list.size(); i++)
 	{
@@ -925,14 +2405,8 @@ int SAT_encoder::calculate_sgs_makespan(vector<Task>& task_list)
 
 	for (int i = 0; i < task_list.size(); i++)
 	{
-		task_list[i].earliest_start_time = find_earliest_start_time(task_list[i].duration, task_list[i].resource_requirements, remaining_resources, task_list[i].earliest_start_time);
-		for (int j = 0; j < task_list[i].duration; j++)
-		{
-			for (int k = 0; k < task_list[i].resource_requirements.size(); k++)
-			{
-				remaining_resources[task_list[i].earliest_start_time + j][k] = remaining_resources[task_list[i].earliest_start_time + j][k] - task_list[i].resource_requirements[k];
-			}
-		}
+		task_list[i].earliest_start_time = resource_profile.find_earliest_start_time(task_list[i].duration, task_list[i].resource_requirements, task_list[i].earliest_start_time);
+		resource_profile.reserve(task_list[i].earliest_start_time, task_list[i].duration, task_list[i].resource_requirements);
 
 		for (int j = 0; j < task_list[i].successors.size(); j++)
 		{
@@ -949,148 +2423,151 @@ int SAT_encoder::calculate_sgs_makespan(vector<Task>& task_list)
 	return task_list.back().earliest_start_time + task_list.back().duration;
 }
 
-int SAT_encoder::find_earliest_start_time(int duration, vector<int> resource_requirements, vector<vector<int>>& remaining_resources, int earliest_start_time)
+void SAT_encoder::write_cnf_file(vector<Task>& task_list, string project_lib_file)
 {
-	bool found_possible_timeslot = false;
-	while (!found_possible_timeslot) {
-		bool requirements_to_high = false;
-		for (int i = 0; i < duration; i++)
-		{
-			for (int j = 0; j < resource_requirements.size(); j++)
-			{
-				if (resource_requirements[j] > remaining_resources[earliest_start_time + i][j])
-				{
-					requirements_to_high = true;
-				}
-			}
-		}
-		if (requirements_to_high) {
-			earliest_start_time++;
-		}
-		else {
-			found_possible_timeslot = true;
-		}
-	}
-
-	return earliest_start_time;
+	Wcnf_file_sink clause_sink(extract_filename_without_extention(project_lib_file) + '.' + cnf_file_type, get_cnf_hard_clause_weight());
+	build_clauses(task_list, clause_sink);
+	clause_sink.close();
 }
 
-void SAT_encoder::write_cnf_file(vector<Task>& task_list, string project_lib_file)
+void SAT_encoder::build_clauses(vector<Task>& task_list, Clause_sink& clause_sink)
 {
-	stringstream cnf_file_content;
-	int clause_count = 0;
-	build_completion_clauses(task_list, cnf_file_content, clause_count);
-	build_precedence_clauses(task_list, cnf_file_content, clause_count);
-	build_consistency_clauses(task_list, cnf_file_content, clause_count);
-	build_resource_clauses(task_list, cnf_file_content, clause_count);
-	build_objective_clauses(task_list, cnf_file_content, clause_count);
-
-	ofstream schedule_file(extract_filename_without_extention(project_lib_file) + '.' + cnf_file_type);
-	if (schedule_file.is_open())
-	{
-		// p FORMAT VARIABLES CLAUSES
-		schedule_file << 'p' << ' ' << cnf_file_type << ' ' << cnf_variable.get_variable_count() << ' ' << clause_count << ' ' << get_cnf_hard_clause_weight() << '\n';
-		schedule_file << cnf_file_content.str();
-		schedule_file.close();
+	clause_sink.set_variable_count(cnf_variable.get_variable_count());
+	build_completion_clauses(task_list, clause_sink);
+	build_precedence_clauses(task_list, clause_sink);
+	build_consistency_clauses(task_list, clause_sink);
+	if (use_order_encoding) {
+		build_order_clauses(task_list, clause_sink);
 	}
+	if (use_process_aggregates) {
+		build_process_aggregate_clauses(task_list, clause_sink);
+	}
+	build_resource_clauses(task_list, clause_sink);
+	build_objective_clauses(task_list, clause_sink);
+	clause_sink.set_variable_count(cnf_variable.get_variable_count());
 }
 
-void SAT_encoder::build_completion_clauses(vector<Task>& task_list, stringstream& cnf_file_content, int& clause_count)
+void SAT_encoder::build_completion_clauses(vector<Task>& task_list, Clause_sink& clause_sink)
 {
+	vector<int32_t> clause;
 
-	for (Task task : parsed_tasks)
+	for (Task& task : parsed_tasks)
 	{
 		if (task.id == 0)
 		{
 			continue;
 		}
 
-		vector<Task> task_segments;
+		vector<Task*> task_segments;
 
-		for (Task task_segment : task_list)
+		for (Task& task_segment : task_list)
 		{
 			if (task_segment.id == task.id) {
-				task_segments.push_back(task_segment);
+				task_segments.push_back(&task_segment);
 			}
 		}
 
 		for (int time_slot = 1; time_slot <= task.duration; time_slot++)
 		{
-			vector<Task> active_task_segments;
-			for (Task task_segment : task_segments)
+			clause.clear();
+			for (Task* task_segment : task_segments)
 			{
-				if (task_segment.segment <= time_slot && task_segment.segment + task_segment.duration - 1 >= time_slot) {
-					active_task_segments.push_back(task_segment);
+				if (task_segment->segment > time_slot || task_segment->segment + task_segment->duration - task_segment->setup_time - 1 < time_slot) {
+					continue;
 				}
-			}
-			cnf_file_content << get_cnf_hard_clause_weight() << ' ';
-			for (Task active_task_segment : active_task_segments)
-			{
-				for (int32_t start_variable : active_task_segment.start_variables)
+				// With the order encoding a segment is started at all if it started at or before its latest start
+				if (use_order_encoding) {
+					if (!task_segment->order_variables.empty()) {
+						clause.push_back(task_segment->order_variables.back());
+					}
+					continue;
+				}
+				for (int32_t start_variable : task_segment->start_variables)
 				{
-					cnf_file_content << start_variable << ' ';
+					clause.push_back(start_variable);
 				}
 			}
-			cnf_file_content << '0' << '\n';
-			clause_count++;
+			clause_sink.add_hard_clause(clause);
 		}
 
 	}
 }
 
-void SAT_encoder::build_precedence_clauses(vector<Task>& task_list, stringstream& cnf_file_content, int& clause_count)
+// A segment needs a started segment of each of its predecessor tasks, or of its own task for a later segment, that finishes in
+// time. The predecessors are looked up once per (task id, segment) instead of comparing all pairs of segments.
+void SAT_encoder::build_precedence_clauses(vector<Task>& task_list, Clause_sink& clause_sink)
 {
-	for (Task successor : task_list)
+	map<pair<int, int>, vector<int>> predecessor_indices; // successor task id and segment -> indices in task_list
+	for (int k = 0; k < task_list.size(); k++)
 	{
-		if (successor.id == 0)
+		if (task_list[k].id == 0)
 		{
 			continue;
 		}
+		for (pair<int, int>& successor_id_segment : task_list[k].successors)
+		{
+			predecessor_indices[successor_id_segment].push_back(k);
+		}
+	}
+
+	vector<int32_t> clause;
 
-		vector<vector<Task>> predecessor_groups(parsed_tasks.size());
-		for (Task predecessor : task_list)
+	for (Task& successor : task_list)
+	{
+		if (successor.id == 0)
 		{
-			if (predecessor.id == 0)
-			{
-				continue;
-			}
+			continue;
+		}
+		auto found_predecessors = predecessor_indices.find(pair<int, int>(successor.id, successor.segment));
+		if (found_predecessors == predecessor_indices.end())
+		{
+			continue;
+		}
 
-			for (pair<int, int> successor_id_segment : predecessor.successors)
+		// One clause per start time and predecessor task
+		vector<int> predecessors = found_predecessors->second;
+		stable_sort(predecessors.begin(), predecessors.end(), [&task_list](int lhs, int rhs) {return task_list[lhs].id < task_list[rhs].id; });
+		for (int group_start = 0; group_start < predecessors.size();)
+		{
+			int group_end = group_start;
+			while (group_end < predecessors.size() && task_list[predecessors[group_end]].id == task_list[predecessors[group_start]].id)
 			{
-				if (successor.id == successor_id_segment.first && successor.segment == successor_id_segment.second)
-				{
-					predecessor_groups[predecessor.id].push_back(predecessor);
-				}
+				group_end++;
 			}
-		}
 
-		for (vector<Task> predecessor_group : predecessor_groups)
-		{
 			for (int i = 0; i < successor.start_variables.size(); i++)
 			{
-				if (predecessor_group.size() > 0) {
-					cnf_file_content << get_cnf_hard_clause_weight() << ' ';
-					cnf_file_content << '-' << successor.start_variables[i] << ' ';
-					for (Task predecessor : predecessor_group)
-					{
-						assert(i + successor.early_start - predecessor.duration - predecessor.early_start >= 0);
-						assert(predecessor.start_variables.size() >= 0);
-						for (int j = 0; j <= i + successor.early_start - predecessor.duration - predecessor.early_start && j < predecessor.start_variables.size(); j++)
-						{
-							cnf_file_content << predecessor.start_variables[j] << ' ';
+				clause.clear();
+				clause.push_back(-successor.start_variables[i]);
+				for (int k = group_start; k < group_end; k++)
+				{
+					Task& predecessor = task_list[predecessors[k]];
+					int latest_start_index = i + successor.early_start - predecessor.duration - predecessor.early_start;
+					assert(latest_start_index >= 0);
+					if (use_order_encoding) {
+						if (latest_start_index >= 0 && !predecessor.order_variables.empty()) {
+							clause.push_back(predecessor.order_variables[min(latest_start_index, (int)predecessor.order_variables.size() - 1)]);
 						}
+						continue;
+					}
+					for (int j = 0; j <= latest_start_index && j < predecessor.start_variables.size(); j++)
+					{
+						clause.push_back(predecessor.start_variables[j]);
 					}
-					cnf_file_content << '0' << '\n';
-					clause_count++;
 				}
+				clause_sink.add_hard_clause(clause);
 			}
+
+			group_start = group_end;
 		}
 	}
 }
 
-void SAT_encoder::build_consistency_clauses(vector<Task>& task_list, stringstream& cnf_file_content, int& clause_count)
+void SAT_encoder::build_consistency_clauses(vector<Task>& task_list, Clause_sink& clause_sink)
 {
-	for (Task task : task_list)
+	vector<int32_t> clause(2);
+
+	for (Task& task : task_list)
 	{
 		if (task.id == 0)
 		{
@@ -1101,80 +2578,374 @@ void SAT_encoder::build_consistency_clauses(vector<Task>& task_list, stringstrea
 		{
 			for (int j = i; j < i + task.duration; j++)
 			{
-				cnf_file_content << get_cnf_hard_clause_weight() << ' ';
-				cnf_file_content << '-' << task.start_variables[i] << ' ';
-				cnf_file_content << task.process_variables[j] << ' ';
-				cnf_file_content << '0' << '\n';
-				clause_count++;
+				clause[0] = -task.start_variables[i];
+				clause[1] = task.process_variables[j];
+				clause_sink.add_hard_clause(clause);
 			}
 		}
 	}
 }
 
-void SAT_encoder::build_resource_clauses(vector<Task>& task_list, stringstream& cnf_file_content, int& clause_count)
+// The order variables follow from the start variables: a start at some time sets the order variable of that time, which sets all
+// later ones, and an order variable needs a start at its time or the previous order variable
+void SAT_encoder::build_order_clauses(vector<Task>& task_list, Clause_sink& clause_sink)
 {
-	for (int i = 0; i < resource_availabilities.size(); i++)
+	vector<int32_t> clause;
+
+	for (Task& task : task_list)
 	{
-		for (int j = 0; j <= upper_bound_makespan; j++)
+		for (int i = 0; i < task.order_variables.size(); i++)
+		{
+			clause = vector<int32_t>{ -task.start_variables[i], task.order_variables[i] };
+			clause_sink.add_hard_clause(clause);
+			if (i > 0) {
+				clause = vector<int32_t>{ -task.order_variables[i - 1], task.order_variables[i] };
+				clause_sink.add_hard_clause(clause);
+				clause = vector<int32_t>{ -task.order_variables[i], task.start_variables[i], task.order_variables[i - 1] };
+			}
+			else {
+				clause = vector<int32_t>{ -task.order_variables[i], task.start_variables[i] };
+			}
+			clause_sink.add_hard_clause(clause);
+		}
+	}
+}
+
+// A segment that processes its task at some time implies the aggregate of the task at that time. The converse is not needed: the
+// aggregates only appear in the resource constraints, where a true aggregate without a processing segment only uses capacity.
+void SAT_encoder::build_process_aggregate_clauses(vector<Task>& task_list, Clause_sink& clause_sink)
+{
+	vector<int32_t> clause(2);
+
+	for (Task& segment : task_list)
+	{
+		if (segment.id == 0)
+		{
+			continue;
+		}
+
+		Task& task = parsed_tasks[task_graph.task_index[segment.id]];
+		for (int j = 0; j < segment.process_variables.size(); j++)
+		{
+			clause[0] = -segment.process_variables[j];
+			clause[1] = task.process_aggregate_variables[segment.early_start + j - task.early_start];
+			clause_sink.add_hard_clause(clause);
+		}
+	}
+}
+
+void SAT_encoder::build_resource_clauses(vector<Task>& task_list, Clause_sink& clause_sink)
+{
+	if (encoding_threads > 1)
+	{
+		build_resource_clauses_parallel(task_list, clause_sink);
+		return;
+	}
+
+	for (pair<int, int> resource_time_point : select_resource_time_points(task_list))
+	{
+		int resource = resource_time_point.first;
+		vector<int64_t> weights;
+		vector<int32_t> literals;
+		collect_resource_constraint(task_list, resource, resource_time_point.second, weights, literals);
+
+		if (use_resource_encoding_cache)
+		{
+			sort_resource_constraint(weights, literals);
+			pair<vector<int64_t>, int64_t> shape(weights, resource_availabilities[resource]);
+			auto cached_template = resource_encoding_cache.find(shape);
+			if (cached_template == resource_encoding_cache.end())
+			{
+				cached_template = resource_encoding_cache.emplace(shape, encode_resource_template(pb2cnf, weights, resource_availabilities[resource])).first;
+			}
+			add_resource_template_clauses(cached_template->second, literals, clause_sink);
+			continue;
+		}
+
+		vector<vector<int32_t>> formula;
+		int32_t first_fresh_variable = cnf_variable.get_variable_count() + 1;
+		int resource_availability = resource_availabilities[resource];
+		first_fresh_variable = pb2cnf.encodeLeq(weights, literals, resource_availability, formula, first_fresh_variable) + 1;
+		cnf_variable.set_last_used_variable(first_fresh_variable - 1);
+		clause_sink.set_variable_count(cnf_variable.get_variable_count());
+
+		for (vector<int32_t>& disjunction : formula)
+		{
+			clause_sink.add_hard_clause(disjunction);
+		}
+	}
+}
+
+// Encodes the resource constraints in batches on encoding_threads threads. Every constraint in a batch is encoded with its auxiliary
+// variables starting at the same first fresh variable, afterwards the auxiliary variables are shifted in the serial order of the
+// constraints. The resulting clauses are identical to the ones of the serial encoding. With the resource encoding cache only the
+// templates that are missing from the cache are encoded concurrently.
+void SAT_encoder::build_resource_clauses_parallel(vector<Task>& task_list, Clause_sink& clause_sink)
+{
+	const int batch_size = encoding_threads * 256;
+
+	vector<pair<int, int>> resource_time_points = select_resource_time_points(task_list);
+
+	vector<Resource_constraint> batch;
+	for (int batch_start = 0; batch_start < resource_time_points.size(); batch_start += batch_size)
+	{
+		int batch_end = min((int)resource_time_points.size(), batch_start + batch_size);
+		batch = vector<Resource_constraint>(batch_end - batch_start);
+		for (int k = batch_start; k < batch_end; k++)
+		{
+			Resource_constraint& constraint = batch[k - batch_start];
+			collect_resource_constraint(task_list, resource_time_points[k].first, resource_time_points[k].second, constraint.weights, constraint.literals);
+			constraint.capacity = resource_availabilities[resource_time_points[k].first];
+		}
+
+		if (use_resource_encoding_cache)
 		{
-			vector<int64_t> weights;
-			vector<int32_t> literals;
-			for (Task task : task_list)
+			vector<pair<vector<int64_t>, int64_t>> missing_shapes;
+			for (Resource_constraint& constraint : batch)
 			{
-				if (task.duration == 0)
+				sort_resource_constraint(constraint.weights, constraint.literals);
+				pair<vector<int64_t>, int64_t> shape(constraint.weights, constraint.capacity);
+				if (resource_encoding_cache.find(shape) == resource_encoding_cache.end() && find(missing_shapes.begin(), missing_shapes.end(), shape) == missing_shapes.end())
 				{
-					continue;
+					missing_shapes.push_back(shape);
+				}
+			}
+
+			vector<Resource_encoding_template> missing_templates(missing_shapes.size());
+			atomic<int> next_shape(0);
+			vector<thread> workers;
+			for (int t = 0; t < encoding_threads; t++)
+			{
+				workers.push_back(thread([this, &missing_shapes, &missing_templates, &next_shape]() {
+					PB2CNF thread_pb2cnf;
+					for (int k = next_shape++; k < missing_shapes.size(); k = next_shape++)
+					{
+						missing_templates[k] = encode_resource_template(thread_pb2cnf, missing_shapes[k].first, missing_shapes[k].second);
+					}
+				}));
+			}
+			for (thread& worker : workers)
+			{
+				worker.join();
+			}
+			for (int k = 0; k < missing_shapes.size(); k++)
+			{
+				resource_encoding_cache.emplace(missing_shapes[k], missing_templates[k]);
+			}
+
+			for (Resource_constraint& constraint : batch)
+			{
+				add_resource_template_clauses(resource_encoding_cache[pair<vector<int64_t>, int64_t>(constraint.weights, constraint.capacity)], constraint.literals, clause_sink);
+			}
+			continue;
+		}
+
+		const int32_t first_fresh_variable = cnf_variable.get_variable_count() + 1;
+		atomic<int> next_constraint(0);
+		vector<thread> workers;
+		for (int t = 0; t < encoding_threads; t++)
+		{
+			workers.push_back(thread([&batch, &next_constraint, first_fresh_variable]() {
+				// PB2CNF keeps state between calls, so every thread needs its own encoder
+				PB2CNF thread_pb2cnf;
+				for (int k = next_constraint++; k < batch.size(); k = next_constraint++)
+				{
+					Resource_constraint& constraint = batch[k];
+					int32_t last_used_variable = thread_pb2cnf.encodeLeq(constraint.weights, constraint.literals, constraint.capacity, constraint.formula, first_fresh_variable);
+					constraint.auxiliary_variable_count = last_used_variable - (first_fresh_variable - 1);
 				}
-				if (task.resource_requirements[i] > 0 && task.early_start <= j && task.late_finish >= j)
+			}));
+		}
+		for (thread& worker : workers)
+		{
+			worker.join();
+		}
+
+		for (Resource_constraint& constraint : batch)
+		{
+			int32_t auxiliary_offset = cnf_variable.get_variable_count() + 1 - first_fresh_variable;
+			cnf_variable.set_last_used_variable(cnf_variable.get_variable_count() + constraint.auxiliary_variable_count);
+			clause_sink.set_variable_count(cnf_variable.get_variable_count());
+
+			for (vector<int32_t>& disjunction : constraint.formula)
+			{
+				for (int32_t& literal : disjunction)
 				{
-					literals.push_back(task.process_variables[j - task.early_start]);
-					weights.push_back(task.resource_requirements[i]);
+					if (literal >= first_fresh_variable) {
+						literal += auxiliary_offset;
+					}
+					else if (-literal >= first_fresh_variable) {
+						literal -= auxiliary_offset;
+					}
 				}
+				clause_sink.add_hard_clause(disjunction);
 			}
+		}
+	}
+}
+
+void SAT_encoder::sort_resource_constraint(vector<int64_t>& weights, vector<int32_t>& literals)
+{
+	vector<pair<int64_t, int32_t>> weighted_literals;
+	for (int k = 0; k < weights.size(); k++)
+	{
+		weighted_literals.push_back(pair<int64_t, int32_t>(weights[k], literals[k]));
+	}
+	stable_sort(weighted_literals.begin(), weighted_literals.end(), [](const pair<int64_t, int32_t>& lhs, const pair<int64_t, int32_t>& rhs) {return lhs.first < rhs.first; });
+	for (int k = 0; k < weighted_literals.size(); k++)
+	{
+		weights[k] = weighted_literals[k].first;
+		literals[k] = weighted_literals[k].second;
+	}
+}
 
-			vector<vector<int32_t>> formula;
-			int32_t first_fresh_variable = cnf_variable.get_variable_count() + 1;
-			int resource_availability = resource_availabilities[i];
-			first_fresh_variable = pb2cnf.encodeLeq(weights, literals, resource_availability, formula, first_fresh_variable) + 1;
-			cnf_variable.set_last_used_variable(first_fresh_variable - 1);
+SAT_encoder::Resource_encoding_template SAT_encoder::encode_resource_template(PB2CNF& encoder, vector<int64_t>& sorted_weights, int64_t capacity)
+{
+	Resource_encoding_template encoding_template;
+	encoding_template.literal_count = sorted_weights.size();
+
+	vector<int32_t> placeholder_literals;
+	for (int32_t k = 1; k <= encoding_template.literal_count; k++)
+	{
+		placeholder_literals.push_back(k);
+	}
+
+	int32_t last_used_variable = encoder.encodeLeq(sorted_weights, placeholder_literals, capacity, encoding_template.formula, encoding_template.literal_count + 1);
+	encoding_template.auxiliary_variable_count = last_used_variable - encoding_template.literal_count;
+	return encoding_template;
+}
+
+void SAT_encoder::add_resource_template_clauses(Resource_encoding_template& encoding_template, vector<int32_t>& sorted_literals, Clause_sink& clause_sink)
+{
+	int32_t auxiliary_offset = cnf_variable.get_variable_count() - encoding_template.literal_count;
+	cnf_variable.set_last_used_variable(cnf_variable.get_variable_count() + encoding_template.auxiliary_variable_count);
+	clause_sink.set_variable_count(cnf_variable.get_variable_count());
+
+	vector<int32_t> clause;
+	for (vector<int32_t>& template_clause : encoding_template.formula)
+	{
+		clause.clear();
+		for (int32_t template_literal : template_clause)
+		{
+			int32_t variable = abs(template_literal);
+			variable = variable <= encoding_template.literal_count ? sorted_literals[variable - 1] : variable + auxiliary_offset;
+			clause.push_back(template_literal > 0 ? variable : -variable);
+		}
+		clause_sink.add_hard_clause(clause);
+	}
+}
+
+// The resource and time pairs that need a resource constraint, written to stderr with the number of pairs that were skipped. With
+// the event points a resource is only constrained at the times at which a segment that uses it can start: the segments that run at
+// any other time were all started earlier and still run one time step before, where they are constrained already. A constraint
+// whose literals cannot exceed the capacity together is skipped in any case.
+vector<pair<int, int>> SAT_encoder::select_resource_time_points(vector<Task>& task_list)
+{
+	vector<pair<int, int>> resource_time_points;
+	int without_start_count = 0;
+	int within_capacity_count = 0;
 
-			for (vector<int32_t> disjunction : formula)
+	for (int i = 0; i < resource_availabilities.size(); i++)
+	{
+		vector<bool> can_start(upper_bound_makespan + 1, !use_resource_event_points);
+		vector<long long> total_weights(upper_bound_makespan + 1, 0);
+		for (Task& task : task_list)
+		{
+			if (task.duration == 0 || task.resource_requirements[i] == 0)
+			{
+				continue;
+			}
+			for (int t = max(0, task.early_start); t < task.early_start + (int)task.start_variables.size() && t <= upper_bound_makespan; t++)
+			{
+				can_start[t] = true;
+			}
+			if (!use_process_aggregates) {
+				for (int t = max(0, task.early_start); t <= task.late_finish && t <= upper_bound_makespan; t++)
+				{
+					total_weights[t] += task.resource_requirements[i];
+				}
+			}
+		}
+		if (use_process_aggregates) {
+			for (Task& task : parsed_tasks)
 			{
-				cnf_file_content << get_cnf_hard_clause_weight() << ' ';
-				for (int32_t variable : disjunction)
+				for (int j = 0; j < task.process_aggregate_variables.size(); j++)
 				{
-					cnf_file_content << variable << ' ';
+					int t = task.early_start + j;
+					if (task.process_aggregate_variables[j] != 0 && t >= 0 && t <= upper_bound_makespan) {
+						total_weights[t] += task.resource_requirements[i];
+					}
 				}
-				cnf_file_content << '0' << '\n';
-				clause_count++;
 			}
 		}
+
+		for (int j = 0; j <= upper_bound_makespan; j++)
+		{
+			if (!can_start[j]) {
+				without_start_count++;
+			}
+			else if (total_weights[j] <= resource_availabilities[i]) {
+				within_capacity_count++;
+			}
+			else {
+				resource_time_points.push_back(pair<int, int>(i, j));
+			}
+		}
+	}
+
+	cerr << "resource constraints removed: " << without_start_count << " without a start, " << within_capacity_count << " within capacity, " << resource_time_points.size() << " kept" << '\n';
+	return resource_time_points;
+}
+
+void SAT_encoder::collect_resource_constraint(vector<Task>& task_list, int resource, int time, vector<int64_t>& weights, vector<int32_t>& literals)
+{
+	if (use_process_aggregates)
+	{
+		for (Task& task : parsed_tasks)
+		{
+			int index = time - task.early_start;
+			if (task.resource_requirements[resource] > 0 && index >= 0 && index < task.process_aggregate_variables.size() && task.process_aggregate_variables[index] != 0)
+			{
+				literals.push_back(task.process_aggregate_variables[index]);
+				weights.push_back(task.resource_requirements[resource]);
+			}
+		}
+		return;
+	}
+
+	for (Task& task : task_list)
+	{
+		if (task.duration == 0)
+		{
+			continue;
+		}
+		if (task.resource_requirements[resource] > 0 && task.early_start <= time && task.late_finish >= time)
+		{
+			literals.push_back(task.process_variables[time - task.early_start]);
+			weights.push_back(task.resource_requirements[resource]);
+		}
 	}
 }
 
-void SAT_encoder::build_objective_clauses(vector<Task>& task_list, stringstream& cnf_file_content, int& clause_count)
+void SAT_encoder::build_objective_clauses(vector<Task>& task_list, Clause_sink& clause_sink)
 {
 	Task finish = task_list.back();
 
 	int32_t latest_start_variable = cnf_variable.get_variable();
-	cnf_file_content << get_cnf_hard_clause_weight() << ' ';
-	cnf_file_content << '-' << latest_start_variable << ' ';
-	cnf_file_content << '0' << '\n';
-	clause_count++;
+	clause_sink.set_variable_count(cnf_variable.get_variable_count());
 
-	cnf_file_content << finish.early_start << ' ';
-	cnf_file_content << latest_start_variable << ' ';
-	cnf_file_content << '0' << '\n';
-	clause_count++;
+	vector<int32_t> clause{ -latest_start_variable };
+	clause_sink.add_hard_clause(clause);
+
+	clause = vector<int32_t>{ latest_start_variable };
+	clause_sink.add_soft_clause(clause, finish.early_start);
 
 	vector<int32_t> literals;
 
 	for (int i = 0; i < finish.start_variables.size(); i++)
 	{
-		cnf_file_content << 1 << ' ';
-		cnf_file_content << finish.start_variables[i] << ' ';
-		cnf_file_content << '0' << '\n';
-		clause_count++;
+		clause = vector<int32_t>{ finish.start_variables[i] };
+		clause_sink.add_soft_clause(clause, 1);
 		literals.push_back(finish.start_variables[i]);
 	}
 }
@@ -1190,4 +2961,51 @@ static string extract_filename_without_extention(string file_path)
 int SAT_encoder::get_cnf_hard_clause_weight()
 {
 	return ((horizon * (horizon + 1)) / 2) + 1;
+}
+
+Hybrid_solution_exchange::Hybrid_solution_exchange(Heuristic_Solver& heuristic_solver, SAT_encoder& sat_encoder) :
+	heuristic_solver(heuristic_solver), sat_encoder(sat_encoder)
+{
+}
+
+void Hybrid_solution_exchange::submit_heuristic_solution(Heuristic_Solver::Solution& solution)
+{
+	lock_guard<mutex> lock(exchange_mutex);
+	if (solution.makespan < best_makespan) {
+		heuristic_solution = solution;
+		has_heuristic_solution = true;
+	}
+}
+
+bool Hybrid_solution_exchange::HasExternalSolution()
+{
+	lock_guard<mutex> lock(exchange_mutex);
+	return has_heuristic_solution;
+}
+
+vector<int32_t> Hybrid_solution_exchange::TakeExternalSolution()
+{
+	Heuristic_Solver::Solution solution;
+	{
+		lock_guard<mutex> lock(exchange_mutex);
+		if (!has_heuristic_solution) {
+			return vector<int32_t>();
+		}
+		solution = heuristic_solution;
+		has_heuristic_solution = false;
+	}
+	return sat_encoder.create_warm_start_assignment(solution);
+}
+
+void Hybrid_solution_exchange::ReportSolution(const vector<bool>& input_variable_values, int64_t cost, int64_t lower_bound)
+{
+	{
+		lock_guard<mutex> lock(exchange_mutex);
+		best_makespan = (int)cost;
+		if (has_heuristic_solution && heuristic_solution.makespan >= best_makespan) {
+			has_heuristic_solution = false;
+		}
+	}
+	heuristic_solver.set_lower_bound((int)lower_bound);
+	heuristic_solver.submit_task_order(sat_encoder.decode_task_order(input_variable_values));
 }
\ No newline at end of file
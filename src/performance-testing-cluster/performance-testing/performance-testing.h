@@ -11,6 +11,15 @@
 #include <ctime>
 #include <tuple>
 #include <filesystem>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+#include <atomic>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <chrono>
+#include <functional>
 #include "../pblib/pblib/pb2cnf.h"
 #include "../pumpkin-solver/pumpkin-solver/pumpkin-solver.h"
 
@@ -25,8 +34,133 @@ string project_file_name;
 const string cnf_file_type = "wcnf";
 static string extract_filename_without_extention(string file_path);
 
+// Optional parameters, given as "-name value" pairs after the required command line parameters
+bool encode_in_memory = false; // pass the clauses directly to the solver instead of through a wcnf file
+int encoding_threads = 1; // number of threads used to encode the resource constraints
+bool use_resource_encoding_cache = false; // reuse the encoding of resource constraints with the same weights and capacity
+int heuristic_threads = 1; // number of independent large neighbourhood search workers of the heuristic
+int heuristic_restart_interval = 100; // iterations after which a parallel worker restarts from the best solution if it is better
+double heuristic_time_limit = 0; // seconds after which the heuristic stops, 0 to run until it is interrupted
+long long heuristic_iteration_limit = 0; // iterations after which the heuristic stops, 0 for no limit
+long long heuristic_stagnation_limit = 0; // iterations without improvement after which the heuristic stops, 0 for no limit
+bool log_heuristic_improvements = false; // write the makespan and elapsed time of every heuristic improvement to stderr
+bool warm_start_sat = false; // run the heuristic within its budget first and start the SAT solver from its best schedule
+bool solve_hybrid = false; // run the heuristic next to the SAT solver and exchange their solutions until the SAT solver finishes
+double horizon_heuristic_time_limit = 0; // seconds the heuristic runs before the encoding to tighten its horizon, 0 to skip
+bool use_energetic_windows = false; // narrow the time windows of the tasks by the energy of their ancestors and descendants
+bool use_segment_pruning = true; // drop the segments that cannot be part of a chain that processes their task completely, 0 keeps all segments
+bool use_process_aggregates = true; // let the resource constraints count a task once per time instead of once per segment
+bool use_resource_event_points = true; // only constrain a resource at the times at which a segment that uses it can start
+bool use_order_encoding = false; // refer to "started at or before" literals in the precedence and completion clauses
+bool use_lazy_clause_generation = false; // solve on integer start times of task segments with precedence and cumulative propagators
+int lazy_segment_limit = 0; // segments per task in the lazy clause generation model, 0 for as many as the duration, 1 to not preempt
+static void parse_optional_parameters(int argc, char* argv[], int first_optional_index);
+static void tighten_encoding_horizon(string project_lib_folder, string project_lib_file, int setup_time);
+
+// Receives the clauses generated by the SAT encoder, variables use the DIMACS numbering
+class Clause_sink
+{
+protected:
+	int clause_count = 0;
+
+public:
+	virtual ~Clause_sink() {}
+	virtual void set_variable_count(int32_t variable_count) = 0;
+	virtual void add_hard_clause(vector<int32_t>& clause) = 0;
+	virtual void add_soft_clause(vector<int32_t>& clause, int64_t weight) = 0;
+	int get_clause_count();
+};
+
+// Streams the clauses to a wcnf file through a fixed size buffer, the header counts are written over a padded placeholder on close
+class Wcnf_file_sink : public Clause_sink
+{
+private:
+	static const size_t buffer_size = 1 << 16;
+	static const int header_count_width = 20;
+
+	FILE* cnf_file;
+	vector<char> buffer;
+	size_t buffer_used = 0;
+	int64_t hard_clause_weight;
+	string hard_clause_weight_text;
+	int32_t variable_count = 0;
+
+	void reserve(size_t clause_size);
+	void write_integer(int64_t value);
+	void write_literals(vector<int32_t>& clause);
+	void write_header();
+	void flush();
+
+public:
+	Wcnf_file_sink(string file_name, int64_t hard_clause_weight);
+	~Wcnf_file_sink();
+	void set_variable_count(int32_t variable_count);
+	void add_hard_clause(vector<int32_t>& clause);
+	void add_soft_clause(vector<int32_t>& clause, int64_t weight);
+	void close();
+};
+
+// Adds the clauses directly to the solver, skipping the wcnf file entirely
+class Solver_clause_sink : public Clause_sink
+{
+private:
+	Pumpkin::ConstraintOptimisationSolver& solver;
+
+public:
+	Solver_clause_sink(Pumpkin::ConstraintOptimisationSolver& solver);
+	void set_variable_count(int32_t variable_count);
+	void add_hard_clause(vector<int32_t>& clause);
+	void add_soft_clause(vector<int32_t>& clause, int64_t weight);
+};
+
+// Transitive closure of a precedence graph stored as one bitset per node, bit j of the row of node i is set if i reaches j
+class Reachability_index
+{
+private:
+	int word_count = 0;
+	vector<vector<uint64_t>> reachable;
+	vector<int> released_nodes;
+
+public:
+	int add_node();
+	void add_edge(int from, int to);
+	void release_node(int node);
+	bool reaches_any(int node, vector<uint64_t>& nodes);
+	vector<uint64_t> create_node_set();
+	static void insert(vector<uint64_t>& nodes, int node);
+	static bool contains(vector<uint64_t>& nodes, int node);
+};
+
+// Remaining capacity of every resource over time in one flat time major array, the earliest feasible start of a task scans
+// its window backwards and jumps past the last conflicting time unit instead of stepping one time unit at a time
+class Resource_profile
+{
+private:
+	int time_count = 0;
+	vector<int> resource_availabilities;
+	vector<int> remaining_capacity; // remaining capacity of resource r at time t is at index t * resource count + r
+
+	void grow(int new_time_count);
+
+public:
+	void reset(int horizon, vector<int>& resource_availabilities);
+	int find_earliest_start_time(int duration, vector<int>& resource_requirements, int earliest_start_time);
+	void reserve(int start_time, int duration, vector<int>& resource_requirements);
+	void release(int start_time, int duration, vector<int>& resource_requirements);
+};
+
 class Heuristic_Solver
 {
+public:
+	// Schedule of the best task list found, one entry per scheduled task part in task list order
+	struct Solution
+	{
+		int makespan = 0;
+		vector<int> task_ids; // parsed task the part belongs to
+		vector<int> durations;
+		vector<int> start_times;
+	};
+
 private:
 	struct Id
 	{
@@ -46,29 +180,66 @@ private:
 		}
 	};
 
-	struct Task
+	// Every task and task part created so far as a structure of arrays indexed by split task id, task lists only hold split
+	// task ids so copying or reordering a list never copies the task data
+	struct Task_store
 	{
-		int task_id;
-		int split_task_id;
-		vector<int> successors;
-		int duration;
-		vector<int> resource_requirements; // default value required
-		double rur; // resource utility rate
+		vector<int> task_id; // parsed task the part belongs to
+		vector<int> duration;
+		vector<vector<int>> successors;
 
-		void calculate_rur(vector<int>& resource_availabilities)
-		{
-			rur = 0;
-			for (int i = 0; i < resource_availabilities.size(); i++)
-			{
-				rur += (double)resource_requirements[i] / (double)resource_availabilities[i];
-			}
-			rur *= duration;
-		}
+		// Indexed by parsed task id and shared by all parts of a task
+		vector<vector<int>> resource_requirements;
+		vector<double> rur; // resource utility rate
+	};
 
-		bool operator > (const Task& o) const
-		{
-			return (rur > o.rur);
-		}
+	// State of the serial schedule generation scheme after scheduling a prefix of a task list, the changes made while
+	// evaluating a candidate insertion are recorded so they can be undone and the prefix reused for the next candidate
+	struct Schedule_state
+	{
+		Resource_profile resource_profile;
+		vector<int> start_times;
+
+		bool record_changes = false;
+		vector<pair<int, int>> start_time_changes; // split task id, previous start time
+		vector<pair<int, int>> reservations; // start time, split task id
+	};
+
+	// Solution of a parallel worker, including the task parts and reachability its task list refers to
+	struct Incumbent
+	{
+		int makespan;
+		vector<int> task_list;
+		Task_store tasks;
+		Id job_id;
+		Reachability_index reachability;
+		vector<int> reachability_node;
+	};
+
+	// Best solution over all parallel workers, the makespan is kept separately so it can be read without touching the solution.
+	// The slot is a lock-free atomic pointer to an immutable solution. A published solution is never freed before the slot, since
+	// readers may still copy it, every publication lowers the makespan so at most one solution per makespan value is kept.
+	struct Shared_incumbent
+	{
+		atomic<int> makespan{ INT_MAX };
+		atomic<const Incumbent*> solution{ nullptr };
+		vector<vector<unique_ptr<const Incumbent>>> published_solutions; // worker index -> the solutions it published
+
+		// Iterations over all workers, used for the iteration and stagnation budgets
+		atomic<long long> iterations{ 0 };
+		atomic<long long> last_improvement_iteration{ 0 };
+		mutex improvement_callback_mutex;
+	};
+
+	// Input from another search that runs at the same time, shared by the parallel workers
+	struct External_control
+	{
+		mutex task_order_mutex;
+		vector<int> task_order; // parsed task ids, only the latest submitted order is kept
+		atomic<bool> has_task_order{ false };
+
+		atomic<bool> stop_requested{ false };
+		atomic<int> lower_bound{ 0 };
 	};
 
 	// Parameters to tune the algorithm
@@ -78,7 +249,7 @@ private:
 	int horizon;
 	int optimal_solution;
 	int initial_task_count;
-	vector<Task> initial_tasks;
+	Task_store tasks;
 	int resource_count;
 	vector<int> resource_availabilities;
 
@@ -87,21 +258,80 @@ private:
 	// Global task counter to prevent duplicates
 	Id job_id;
 
+	// Reachability between the split task ids, kept up to date when tasks are split and released again when they are discarded
+	Reachability_index reachability;
+	vector<int> reachability_node; // split task id -> node in reachability, -1 if none
+
+	// Scratch workspace reused by every schedule evaluation
+	Schedule_state schedule_state;
+
+	// Search budget, measured from the start of solve
+	chrono::steady_clock::time_point search_start;
+	long long time_limit_milliseconds = 0;
+	long long iteration_limit = 0;
+	long long stagnation_limit = 0;
+	function<void(int, double)> improvement_callback;
+	function<void(Solution&)> solution_callback;
+	Solution best_solution;
+
+	shared_ptr<External_control> external_control = make_shared<External_control>();
+	shared_ptr<const Incumbent> unsplit_state; // parsed tasks before any split, submitted task orders are evaluated on it
+
+	// Parallel workers draw from their own seeded generator instead of rand()
+	bool use_random_generator = false;
+	mt19937 random_generator;
+	shared_ptr<Shared_incumbent> shared_incumbent;
+	int worker_index = 0; // the solver that starts the workers publishes as worker heuristic_threads
+
 	void parse_activities(string filename);
 	void calculate_rurs();
-	void fix_presedence_constraint(vector<Task>& task_list);
+	int create_task_part(int split_task_id, int duration, int successor_count);
+	void release_task_part(int split_task_id);
+	void build_reachability_index();
+	int get_reachability_node(int split_task_id);
+	void add_reachability_edges(int split_task_id);
+	void release_reachability_node(int split_task_id);
+	void fix_presedence_constraint(vector<int>& task_list);
 	template<typename t> void move(vector<t>& v, size_t oldIndex, size_t newIndex);
-	template<typename T> vector<T> flatten(vector<vector<T>> const& vec);
-	bool check_presedence_violation(vector<Task>& task_list, vector<int>& task_in_violation_at_index, vector<Task>& complete_task_list);
-	void construct_initial_task_list(vector<Task>& task_list);
-	int calculate_makespan(vector<Task>& task_list, int task_count);
-	int find_earliest_start_time(int duration, vector<int> resource_requirements, vector<vector<int>>& remaining_resources, int earliest_start_time);
-	int construct_schedule(vector<Task>& task_list, vector<int>& start_times, int task_count);
-	int optimize_task_list(int makespan, vector<Task>& job_list, bool preempt_tasks, int setup_time);
+	bool check_presedence_violation(vector<int>& task_list, vector<int>& task_in_violation_at_index);
+	bool has_presedence_violation(vector<int>& task_list);
+	void construct_initial_task_list(vector<int>& task_list);
+	int calculate_makespan(vector<int>& task_list, int task_count);
+	void reset_schedule_state(int task_count);
+	void schedule_task(int split_task_id);
+	void set_start_time(int split_task_id, int start_time);
+	void undo_recorded_changes();
+	int find_best_insertion_index(vector<int>& task_list, int split_task_id, int insertion_count, int task_count);
+	int construct_schedule(vector<int>& task_list, vector<int>& start_times, int task_count);
+	int optimize_task_list(int makespan, vector<int>& task_list, bool preempt_tasks, int setup_time);
+	int get_random_number();
+	bool is_budget_exhausted(long long iterations, long long last_improvement_iteration);
+	double get_elapsed_seconds();
+	void report_improvement(vector<int>& task_list);
+	Solution create_solution(vector<int>& task_list);
+	bool adopt_submitted_task_order(vector<int>& task_list);
+	void solve_parallel(vector<int>& task_list, int setup_time, long long iterations, long long last_improvement_iteration);
+	void run_worker(int worker_index, vector<int> task_list, int setup_time);
+	void publish_incumbent(vector<int>& task_list, long long iteration);
+	void adopt_incumbent(vector<int>& task_list);
 
 public:
+	// Limits the search to the given wall clock time, iteration count and number of iterations without improvement, solve only
+	// returns when one of them is reached, 0 means no limit
+	void set_budget(double time_limit_seconds, long long iteration_limit, long long stagnation_limit);
+	// Called with the makespan and the seconds since the start of solve for the initial and every improved solution, the parallel
+	// workers serialize their calls
+	void set_improvement_callback(function<void(int, double)> improvement_callback);
+	// Like the improvement callback but with the schedule of the solution
+	void set_solution_callback(function<void(Solution&)> solution_callback);
+	// The following can be called from other threads while solve runs. A submitted order of the parsed tasks replaces the
+	// current solution if its schedule is better, the search stops once its makespan reaches the lower bound or stop is called.
+	void submit_task_order(vector<int> task_order);
+	void set_lower_bound(int lower_bound);
+	void stop();
 	int solve(string project_lib_folder, string project_lib_file, int setup_time);
 	int get_best_makespan();
+	Solution get_best_solution();
 };
 
 class SAT_encoder
@@ -113,6 +343,7 @@ private:
 		int segment;
 		vector<pair<int, int>> successors;
 		int duration;
+		int setup_time = 0; // Segments only: the part of the duration spent on resuming the task, the segment processes the rest
 		vector<int> resource_requirements;
 
 		// Heuristic bound variable
@@ -127,6 +358,10 @@ private:
 
 		vector<int32_t> start_variables;
 		vector<int32_t> process_variables;
+		// Parsed tasks only: true if any segment processes the task at early_start + i, 0 if no segment can process it then
+		vector<int32_t> process_aggregate_variables;
+		// Order encoding: true if the segment started at or before early_start + i
+		vector<int32_t> order_variables;
 	};
 
 	struct Task_Id
@@ -154,6 +389,48 @@ private:
 		}
 	};
 
+	// Pseudo-boolean resource constraint for one (resource, time) pair, encoded independently of the others in the parallel mode
+	struct Resource_constraint
+	{
+		vector<int64_t> weights;
+		vector<int32_t> literals;
+		int64_t capacity;
+
+		vector<vector<int32_t>> formula;
+		int32_t auxiliary_variable_count;
+	};
+
+	// Encoding of a resource constraint over the placeholder literals 1..n in order of increasing weight, instantiated for every
+	// constraint with the same weights and capacity by renaming the placeholders and the auxiliary variables
+	struct Resource_encoding_template
+	{
+		vector<vector<int32_t>> formula;
+		int32_t literal_count;
+		int32_t auxiliary_variable_count;
+	};
+
+	// Precedence graph of the parsed tasks with the successors and predecessors of task index i stored in
+	// successor_indices[successor_offsets[i] .. successor_offsets[i + 1]) and likewise for the predecessors
+	struct Task_graph
+	{
+		vector<int> task_index; // parsed task id -> index in parsed_tasks
+		vector<int> successor_offsets;
+		vector<int> successor_indices;
+		vector<int> predecessor_offsets;
+		vector<int> predecessor_indices;
+		vector<int> topological_order;
+		Reachability_index reachability; // node i is the task at index i
+	};
+
+	// Segments of a task in the lazy clause generation model, the first segment is always present and the others follow it in order
+	// while present. A task with a single segment has no presence and length variables and is processed in one piece.
+	struct Lazy_task
+	{
+		vector<Pumpkin::IntegerVariable> presences;
+		vector<Pumpkin::IntegerVariable> start_times;
+		vector<Pumpkin::IntegerVariable> lengths;
+	};
+
 	struct CNF_variable
 	{
 	private:
@@ -176,28 +453,48 @@ private:
 		}
 	};
 
+	void prepare_encoding(string project_lib_folder, string project_lib_file, int setup_time);
+	int compute_time_windows(string project_lib_folder, string project_lib_file);
+	Lazy_task create_lazy_task(Task& task, int segment_count, int setup_time, Pumpkin::ConstraintOptimisationSolver& solver);
+	void add_lazy_segment_end(Lazy_task& lazy_task, int segment, Task& task, Pumpkin::IntegerVariable next_start_time, int setup_time, Pumpkin::ConstraintOptimisationSolver& solver);
 	void parse_input_file(string filename);
+	void build_task_graph();
 	void critical_path();
-	void forward_pass(pair<int, int> task_segment_id, int early_start);
-	void backward_pass(pair<int, int> task_segment_id, int late_finish);
+	void tighten_time_windows();
+	bool tighten_by_precedence_energy();
+	bool tighten_by_interval_energy();
+	vector<int> collect_connected_tasks(int task, vector<int>& offsets, vector<int>& indices);
 	void preempt_tasks(int setup_time);
 	void preempt_task(Task task, int setup_time);
 	void set_start_variables();
 	void set_process_variables();
-	void remove_duplicate_segments(vector<Task>& task_list);
+	void set_process_aggregate_variables();
+	void set_order_variables();
+	void prune_segments(vector<Task>& task_list);
+	long long count_time_indexed_variables(int late_finish_shift);
+	void report_horizon_reduction(int greedy_upper_bound_makespan);
 	void calculate_rurs(vector<Task>& task_list);
 	void fix_presedence_constraint(vector<Task>& task_list);
 	bool check_presedence_violation(vector<Task>& task_list, vector<int>& task_in_violation_at_index);
+	bool has_presedence_violation(vector<Task>& task_list);
 	template <typename t> void move(vector<t>& v, size_t oldIndex, size_t newIndex);
 	void construct_upper_bound_task_list(vector<Task>& task_list);
 	int calculate_sgs_makespan(vector<Task>& task_list);
-	int find_earliest_start_time(int duration, vector<int> resource_requirements, vector<vector<int>>& remaining_resources, int earliest_start_time);
 	void write_cnf_file(vector<Task>& task_list, string project_lib_file);
-	void build_consistency_clauses(vector<Task>& task_list, stringstream& cnf_file_content, int& clause_count);
-	void build_precedence_clauses(vector<Task>& task_list, stringstream& cnf_file_content, int& clause_count);
-	void build_completion_clauses(vector<Task>& task_list, stringstream& cnf_file_content, int& clause_count);
-	void build_resource_clauses(vector<Task>& task_list, stringstream& cnf_file_content, int& clause_count);
-	void build_objective_clauses(vector<Task>& task_list, stringstream& cnf_file_content, int& clause_count);
+	void build_clauses(vector<Task>& task_list, Clause_sink& clause_sink);
+	void build_consistency_clauses(vector<Task>& task_list, Clause_sink& clause_sink);
+	void build_order_clauses(vector<Task>& task_list, Clause_sink& clause_sink);
+	void build_precedence_clauses(vector<Task>& task_list, Clause_sink& clause_sink);
+	void build_completion_clauses(vector<Task>& task_list, Clause_sink& clause_sink);
+	void build_process_aggregate_clauses(vector<Task>& task_list, Clause_sink& clause_sink);
+	void build_resource_clauses(vector<Task>& task_list, Clause_sink& clause_sink);
+	void build_resource_clauses_parallel(vector<Task>& task_list, Clause_sink& clause_sink);
+	vector<pair<int, int>> select_resource_time_points(vector<Task>& task_list);
+	void collect_resource_constraint(vector<Task>& task_list, int resource, int time, vector<int64_t>& weights, vector<int32_t>& literals);
+	void sort_resource_constraint(vector<int64_t>& weights, vector<int32_t>& literals);
+	Resource_encoding_template encode_resource_template(PB2CNF& encoder, vector<int64_t>& sorted_weights, int64_t capacity);
+	void add_resource_template_clauses(Resource_encoding_template& encoding_template, vector<int32_t>& sorted_literals, Clause_sink& clause_sink);
+	void build_objective_clauses(vector<Task>& task_list, Clause_sink& clause_sink);
 	int get_cnf_hard_clause_weight();
 
 	Task_Id unique_task_id;
@@ -205,16 +502,52 @@ private:
 	int horizon;
 	int optimal_solution;
 	vector<Task> parsed_tasks;
+	Task_graph task_graph;
 	vector<int> resource_availabilities;
 	vector<Task> preempted_tasks;
+	int segment_setup_time = 0; // setup time of the resumed preempted_tasks
+	Resource_profile resource_profile; // scratch workspace of calculate_sgs_makespan
 
 	// Global CNF construction variables
 	int upper_bound_makespan;
+	int heuristic_upper_bound = INT_MAX; // makespan of a schedule found before the encoding, replaces the greedy bound if lower
 	PB2CNF pb2cnf;
 	CNF_variable cnf_variable;
+	map<pair<vector<int64_t>, int64_t>, Resource_encoding_template> resource_encoding_cache;
 
 public:
 	string encode(string project_lib_folder, string project_lib_file, int setup_time);
+	void encode(string project_lib_folder, string project_lib_file, int setup_time, Pumpkin::ConstraintOptimisationSolver& solver);
+	// Lazy clause generation model of the parsed tasks: a chain of optional segments with integer start times and lengths per task,
+	// linear inequalities for the chains and precedences and a preemptive cumulative propagator per resource, so its size does not
+	// grow with the horizon and only linearly with the durations
+	void encode_with_propagators(string project_lib_folder, string project_lib_file, int setup_time, Pumpkin::ConstraintOptimisationSolver& solver);
+	// The makespan of any feasible schedule, the horizon of the encoding ends at the lowest of these and the greedy upper bound
+	void set_heuristic_upper_bound(int makespan);
+	vector<int32_t> create_warm_start_assignment(Heuristic_Solver::Solution& solution);
+	vector<int> decode_task_order(const vector<bool>& variable_values);
+};
+
+// Passes the solutions between the heuristic and the SAT solver while both run, the SAT solver imports the latest heuristic
+// schedule at its next restart and every SAT solution is handed to the heuristic as a task order together with the lower bound
+class Hybrid_solution_exchange : public Pumpkin::SolutionExchange
+{
+private:
+	Heuristic_Solver& heuristic_solver;
+	SAT_encoder& sat_encoder;
+
+	mutex exchange_mutex;
+	Heuristic_Solver::Solution heuristic_solution; // latest heuristic solution not yet taken by the SAT solver
+	bool has_heuristic_solution = false;
+	int best_makespan = INT_MAX; // of the SAT solver, worse heuristic solutions are not offered
+
+public:
+	Hybrid_solution_exchange(Heuristic_Solver& heuristic_solver, SAT_encoder& sat_encoder);
+	void submit_heuristic_solution(Heuristic_Solver::Solution& solution);
+
+	bool HasExternalSolution() override;
+	vector<int32_t> TakeExternalSolution() override;
+	void ReportSolution(const vector<bool>& input_variable_values, int64_t cost, int64_t lower_bound) override;
 };
 
 Heuristic_Solver heuristic_solver;
@@ -1,5 +1,8 @@
 #include "constraint_optimisation_solver.h"
 #include "preprocessor.h"
+#include "../Propagators/Cumulative/cumulative_propagator.h"
+#include "../Propagators/Cumulative/preemptive_cumulative_propagator.h"
+#include "../Propagators/Linear Integer Inequality/linear_integer_inequality_propagator.h"
 #include "../Utilities/runtime_assert.h"
 #include "../Utilities/solver_output_checker.h"
 #include "../Utilities/stopwatch.h"
@@ -17,7 +20,12 @@ ConstraintOptimisationSolver::ConstraintOptimisationSolver(ParameterHandler& par
 	linear_searcher_(constrained_satisfaction_solver_.state_, parameters),
 	use_lexicographical_objectives_(parameters.GetBooleanParameter("lexicographical")),
 	optimistic_initial_solution_(parameters.GetBooleanParameter("optimistic-initial-solution")),
-	parameters_(parameters)
+	parameters_(parameters),
+	num_boolean_variables_(0),
+	soft_clause_selector_created_(false),
+	integer_variable_created_(false),
+	retain_input_formula_(parameters.GetBooleanParameter("retain-input-formula")),
+	solution_exchange_(NULL)
 {
 }
 
@@ -117,6 +125,11 @@ SolverOutput ConstraintOptimisationSolver::SolveBMO(int64_t time_limit_in_second
 
 	//proceed with the initial solution	
 	solution_tracker_.UpdateBestSolution(initial_output.solution);
+	if (solution_exchange_ != NULL) 
+	{ 
+		linear_searcher_.SetSolutionExchange(solution_exchange_, num_boolean_variables_);
+		solution_exchange_->ReportSolverSolution(initial_output.solution, num_boolean_variables_, solution_tracker_.UpperBound(), solution_tracker_.LowerBound());
+	}
 
 	//simple preprocessing and lower bound update
 	Preprocessor::RemoveFixedAssignmentsFromObjective(constrained_satisfaction_solver_, objective_function);
@@ -267,6 +280,22 @@ ParameterHandler ConstraintOptimisationSolver::CreateParameterHandler()
 		"General Parameters"
 	);
 
+	parameters.DefineBooleanParameter
+	(
+		"retain-input-formula",
+		"Keeps a compact copy of the input clauses so that the final solution can be verified without reading the input file again.",
+		true, //default value
+		"General Parameters"
+	);
+
+	parameters.DefineBooleanParameter
+	(
+		"verify-by-reparsing",
+		"Debug option: verifies the final solution by parsing the input file a second time instead of using the retained copy of the formula. Only applies when the formula was read from a file.",
+		false, //default value
+		"General Parameters"
+	);
+
 	parameters.DefineStringParameter
 	(
 		"output-file",
@@ -427,11 +456,19 @@ ParameterHandler ConstraintOptimisationSolver::CreateParameterHandler()
 	(
 		"cumulative-lifting",
 		"Strategy used when generating explanations. It should always be better to use lifting.",
-		"in-order",
+		"ON",
 		"Cumulative",
 		{ "OFF", "ON" }
 	);
 
+	parameters.DefineBooleanParameter
+	(
+		"cumulative-energetic-reasoning",
+		"Strengthens the cumulative propagator with energetic reasoning over the intervals between the earliest starts and latest ends of the tasks. It is stronger than time-tabling when the windows of the tasks are wide, but takes time cubic in the number of tasks.",
+		false,
+		"Cumulative"
+	);
+
 	//LINEAR SEARCH PARAMETERS---------------------------------------
 
 	parameters.DefineStringParameter
@@ -499,15 +536,9 @@ ParameterHandler ConstraintOptimisationSolver::CreateParameterHandler()
 	return parameters;
 }
 
-void ConstraintOptimisationSolver::CheckCorrectnessOfParameterHandler(const ParameterHandler& parameters)
+void ConstraintOptimisationSolver::CheckCorrectnessOfParameterHandler(const ParameterHandler&)
 {
 	//to be expanded...
-
-	if (parameters.GetStringParameter("cumulative-lifting") == "ON" && parameters.GetStringParameter("cumulative-task-ordering") != "descending-consumption-special")
-	{
-		std::cout << "for now lifting is only implemented in the special propagator for the cumulative, TODO\n";
-		exit(1);
-	}
 }
 
 LinearFunction ConstraintOptimisationSolver::ConvertToCanonicalForm(LinearFunction& input_function)
@@ -593,6 +624,13 @@ std::vector<ConstraintOptimisationSolver::WeightInterval> ConstraintOptimisation
 
 SolverOutput ConstraintOptimisationSolver::ComputeInitialSolution(LinearFunction& objective_function, Stopwatch& stopwatch)
 {
+	//a consistent warm start assignment is completed by solving under it as assumptions, so it becomes the initial solution
+	if (!warm_start_literals_.empty())
+	{
+		SolverOutput warm_start_output = constrained_satisfaction_solver_.Solve(warm_start_literals_, stopwatch.TimeLeftInSeconds());
+		if (warm_start_output.HasSolution()) { return warm_start_output; }
+	}
+
 	if (optimistic_initial_solution_)
 	{
 		for (Term term : objective_function)
@@ -607,12 +645,18 @@ SolverOutput ConstraintOptimisationSolver::ComputeInitialSolution(LinearFunction
 		}
 	}
 	
+	//otherwise the warm start assignment only steers the search, it takes precedence over the optimistic phases of the objective literals
+	for (BooleanLiteral literal : warm_start_literals_)
+	{
+		constrained_satisfaction_solver_.state_.value_selector_.SetAndFreezeValue(literal);
+	}
+
 	// std::cout << "c computing initial solution...\n";
 
 	//find an initial solution by just looking at the hard constraints
 	SolverOutput initial_output = constrained_satisfaction_solver_.Solve(stopwatch.TimeLeftInSeconds());
 	
-	if (optimistic_initial_solution_) 
+	if (optimistic_initial_solution_ || !warm_start_literals_.empty()) 
 	{ 
 		constrained_satisfaction_solver_.state_.value_selector_.UnfreezeAll();
 	}
@@ -654,7 +698,7 @@ void ConstraintOptimisationSolver::ReadSATFileInternal(GzFileReader& file_reader
 	file_reader.SkipLine();
 	
 	//eagerly create all variables
-	for (int i = 0; i < num_variables; i++) { constrained_satisfaction_solver_.state_.CreateNewIntegerVariable(0, 1); }
+	SetNumBooleanVariables(num_variables);
 
 	// std::cout << "c num_vars: " << num_variables << "; num_clauses: " << num_clauses << "\n";
 
@@ -666,6 +710,11 @@ void ConstraintOptimisationSolver::ReadSATFileInternal(GzFileReader& file_reader
 
 		file_reader.ReadIntegerLine(integers);
 		ConvertDIMASIntegersToClause(integers, clause);
+		if (retain_input_formula_)
+		{
+			RetainDIMACSIntegers(integers, false);
+			input_formula_.AddHardClause(retained_clause_buffer_);
+		}
 		bool conflict_detected = constrained_satisfaction_solver_.state_.propagator_clausal_.AddPermanentClause(clause);
 		pumpkin_assert_permanent(!conflict_detected, "Root conflict detected, in principle this is not an error, but for now we assume something went wrong if the instance is detected unsatisfiable without any search.");
 	}
@@ -682,7 +731,7 @@ void ConstraintOptimisationSolver::ReadMaxSATFileInternal(GzFileReader& file_rea
 	file_reader >> num_variables >> num_clauses;
 	pumpkin_assert_permanent(file_reader.IsOK(), "Error: something went wrong with the input file, the number of variables and number of clauses could not be read properly.");
 	//eagerly create all variables
-	for (int i = 0; i < num_variables; i++) { constrained_satisfaction_solver_.state_.CreateNewIntegerVariable(0, 1); }
+	SetNumBooleanVariables(num_variables);
 
 	int64_t hard_clause_weight;
 	file_reader >> hard_clause_weight;
@@ -703,70 +752,226 @@ void ConstraintOptimisationSolver::ReadMaxSATFileInternal(GzFileReader& file_rea
 		pumpkin_assert_permanent(!integers.empty(), "Error: While reading the file, a clause line has been detected with no integers in it, unexpected.");
 
 		//if hard clause
+		if (retain_input_formula_) { RetainDIMACSIntegers(integers, true); }
+
 		if (integers[0] == hard_clause_weight)
 		{
 			ConvertDIMASIntegersToClause(integers, clause, true);
+			if (retain_input_formula_) { input_formula_.AddHardClause(retained_clause_buffer_); }
 			bool conflict_detected = constrained_satisfaction_solver_.state_.propagator_clausal_.AddPermanentClause(clause);
 			pumpkin_assert_permanent(!conflict_detected, "Root conflict detected, in principle this is not an error, but for now we assume something went wrong if the instance is detected unsatisfiable without any search.");
 		}
 		else //the clause is a soft clause
 		{
 			ConvertDIMASIntegersToClause(integers, clause, true);
-			//even though the solver would preprocess the clause, it is important to do this before adding
-			//	this is because we need to make several decisions based on the form of the clause (see below)
-			constrained_satisfaction_solver_.state_.propagator_clausal_.PreprocessClause(clause);
-
-			//normally for each soft clause, we create a fresh ('selector') variable and add the variable to the soft clause
-			//	then we add the clause as a hard clause, and in the objective we add the selector variable
-			//	however there are a few exceptions, which will be now checked
-
-			//if the soft clause is satisfied at the root level
-			if (clause.size() > 0 && clause[0] == constrained_satisfaction_solver_.state_.true_literal_)
-			{
-				//do nothing, the clause may be ignored
-			}
-			//if the soft clause is unsatisfied at the root level
-			else if (clause.empty())
-			{
-				//add the weight of the clause as a constant to the objective, no need to add the clause itself
-				int64_t weight = integers[0];
-				original_objective_function_.AddConstantTerm(weight);
-			}
-			//if the clause only has one literal, then we do not need to create a new selector variable
-			//	the variable in the clause will be used in the objective function
-			else if (clause.size() == 1)
-			{
-				int64_t weight = integers[0];
-				auto lit_info = constrained_satisfaction_solver_.state_.GetLiteralInformation(clause[0]);
-				//the added term in the objective depends on the polarity of the literal
-				//	note that our objective is a sum of variables, and not a sum of literals (!)
-				if (clause[0].IsNegative())
-				{
-					//add the term weight * variable to the objective
-					original_objective_function_.AddTerm(lit_info.integer_variable, weight);
-				}
-				else
-				{
-					//add the term weight * (1 - variable) to the objective
-					original_objective_function_.AddConstantTerm(weight);
-					original_objective_function_.AddTerm(lit_info.integer_variable, -weight);
-				}
-			}
-			//otherwise we arrive at the standard case, i.e., a soft clause with at least two literals
-			else
-			{
-				int64_t weight = integers[0];
-				IntegerVariable fresh_selector_variable = constrained_satisfaction_solver_.state_.CreateNewIntegerVariable(0, 1);
-				BooleanLiteral soft_literal = constrained_satisfaction_solver_.state_.GetEqualityLiteral(fresh_selector_variable, 1);
-				clause.push_back(soft_literal);
-				original_objective_function_.AddTerm(fresh_selector_variable, weight);
-				bool conflict_detected = constrained_satisfaction_solver_.state_.propagator_clausal_.AddPermanentClause(clause);
-				pumpkin_assert_permanent(!conflict_detected, "Error: unsat after adding a soft clause, strange!");
-			}
+			if (retain_input_formula_) { input_formula_.AddSoftClause(retained_clause_buffer_, integers[0]); }
+			AddSoftClauseInternal(clause, integers[0]);
 		}
 	}
 	pumpkin_assert_permanent(num_clauses_read == num_clauses, "Error: input file specified " + std::to_string(num_clauses) + " but only " + std::to_string(num_clauses_read) + " where found.");
 	int n = 0;
 }
 
+void ConstraintOptimisationSolver::SetNumBooleanVariables(int64_t num_variables)
+{
+	//selector variables of soft clauses and integer variables are created directly after the input variables, so the input variables cannot grow afterwards
+	pumpkin_assert_permanent(num_variables <= num_boolean_variables_ || !soft_clause_selector_created_, "Error: new input variables declared after soft clause selector variables have been created.");
+	pumpkin_assert_permanent(num_variables <= num_boolean_variables_ || !integer_variable_created_, "Error: new input variables declared after integer variables have been created.");
+	while (num_boolean_variables_ < num_variables)
+	{
+		constrained_satisfaction_solver_.state_.CreateNewIntegerVariable(0, 1);
+		num_boolean_variables_++;
+	}
+	if (retain_input_formula_) { input_formula_.SetNumBooleanVariables(num_boolean_variables_); }
+}
+
+void ConstraintOptimisationSolver::AddHardClause(const std::vector<int32_t>& dimacs_literals)
+{
+	ConvertDIMACSLiteralsToClause(dimacs_literals, programmatic_clause_buffer_);
+	if (retain_input_formula_) { input_formula_.AddHardClause(dimacs_literals); }
+	bool conflict_detected = constrained_satisfaction_solver_.state_.propagator_clausal_.AddPermanentClause(programmatic_clause_buffer_);
+	pumpkin_assert_permanent(!conflict_detected, "Root conflict detected, in principle this is not an error, but for now we assume something went wrong if the instance is detected unsatisfiable without any search.");
+}
+
+void ConstraintOptimisationSolver::AddSoftClause(const std::vector<int32_t>& dimacs_literals, int64_t weight)
+{
+	ConvertDIMACSLiteralsToClause(dimacs_literals, programmatic_clause_buffer_);
+	if (retain_input_formula_) { input_formula_.AddSoftClause(dimacs_literals, weight); }
+	AddSoftClauseInternal(programmatic_clause_buffer_, weight);
+}
+
+void ConstraintOptimisationSolver::FinishProgrammaticInput()
+{
+	//same finalisation as done at the end of ReadDIMACSFile
+	constrained_satisfaction_solver_.state_.variable_selector_.Reset(parameters_.GetIntegerParameter("seed"));
+}
+
+IntegerVariable ConstraintOptimisationSolver::CreateIntegerVariable(int lower_bound, int upper_bound)
+{
+	integer_variable_created_ = true;
+	//the unary representation needs at least two values, so a variable fixed to zero is created as a binary variable with an upper bound
+	IntegerVariable variable = constrained_satisfaction_solver_.state_.CreateNewIntegerVariable(lower_bound, std::max(upper_bound, 1));
+	if (upper_bound == 0)
+	{
+		bool conflict_detected = constrained_satisfaction_solver_.state_.SetUpperBoundForVariable(variable, 0);
+		pumpkin_assert_permanent(!conflict_detected, "Sanity check.");
+	}
+	return variable;
+}
+
+void ConstraintOptimisationSolver::AddLinearInequality(std::vector<IntegerVariable>& variables, std::vector<int64_t>& coefficients, int64_t right_hand_side)
+{
+	if (retain_input_formula_) { input_formula_.AddLinearInequality(variables, coefficients, right_hand_side); }
+	constrained_satisfaction_solver_.state_.AddPropagatorCP(new LinearIntegerInequalityPropagator(variables, coefficients, right_hand_side));
+}
+
+void ConstraintOptimisationSolver::AddCumulative(std::vector<IntegerVariable>& start_times, std::vector<int>& durations, std::vector<int>& resource_consumptions, int capacity)
+{
+	if (retain_input_formula_) { input_formula_.AddCumulative(start_times, durations, resource_consumptions, capacity); }
+
+	//the propagator keeps its profile over [0, max_time), which needs to include the latest finish of every task
+	int max_time = 0;
+	for (int i = 0; i < start_times.size(); i++)
+	{
+		max_time = std::max(max_time, constrained_satisfaction_solver_.state_.domain_manager_.GetUpperBound(start_times[i]) + durations[i]);
+	}
+
+	std::string task_ordering = parameters_.GetStringParameter("cumulative-task-ordering");
+	CumulativePropagator::TaskOrderingStrategy ordering_strategy = CumulativePropagator::TaskOrderingStrategy::IN_ORDER;
+	if (task_ordering == "ascending-duration") { ordering_strategy = CumulativePropagator::TaskOrderingStrategy::ASCENDING_DURATION; }
+	else if (task_ordering == "descending-duration") { ordering_strategy = CumulativePropagator::TaskOrderingStrategy::DESCENDING_DURATION; }
+	else if (task_ordering == "ascending-consumption") { ordering_strategy = CumulativePropagator::TaskOrderingStrategy::ASCENDING_CONSUMPTION; }
+	else if (task_ordering == "descending-consumption") { ordering_strategy = CumulativePropagator::TaskOrderingStrategy::DESCENDING_CONSUMPTION; }
+	else if (task_ordering == "descending-consumption-special") { ordering_strategy = CumulativePropagator::TaskOrderingStrategy::DESCENDING_CONSUMPTION_SPECIAL; }
+
+	CumulativePropagator::IncrementalStrategy incremental_strategy = parameters_.GetBooleanParameter("cumulative-incremental") ? CumulativePropagator::IncrementalStrategy::ON : CumulativePropagator::IncrementalStrategy::OFF;
+	CumulativePropagator::LiftingStrategy lifting_strategy = parameters_.GetStringParameter("cumulative-lifting") == "ON" ? CumulativePropagator::LiftingStrategy::ON : CumulativePropagator::LiftingStrategy::OFF;
+	CumulativePropagator::EnergeticReasoningStrategy energetic_reasoning_strategy = parameters_.GetBooleanParameter("cumulative-energetic-reasoning") ? CumulativePropagator::EnergeticReasoningStrategy::ON : CumulativePropagator::EnergeticReasoningStrategy::OFF;
+
+	CumulativePropagator* propagator = new CumulativePropagator(start_times, resource_consumptions, durations, capacity, max_time, ordering_strategy, incremental_strategy, lifting_strategy, energetic_reasoning_strategy);
+	constrained_satisfaction_solver_.state_.AddPropagatorCP(propagator);
+}
+
+void ConstraintOptimisationSolver::AddPreemptiveCumulative(std::vector<IntegerVariable>& presences, std::vector<IntegerVariable>& start_times, std::vector<IntegerVariable>& lengths, std::vector<int>& length_offsets, std::vector<int>& resource_consumptions, int capacity)
+{
+	runtime_assert(presences.size() == start_times.size() && lengths.size() == start_times.size() && length_offsets.size() == start_times.size() && resource_consumptions.size() == start_times.size());
+	if (retain_input_formula_) { input_formula_.AddPreemptiveCumulative(presences, start_times, lengths, length_offsets, resource_consumptions, capacity); }
+
+	std::vector<PreemptiveCumulativePropagator::Segment> segments(start_times.size());
+	for (int i = 0; i < start_times.size(); i++)
+	{
+		segments[i].presence = presences[i];
+		segments[i].start_time = start_times[i];
+		segments[i].length = lengths[i];
+		segments[i].length_offset = length_offsets[i];
+		segments[i].resource_consumption = resource_consumptions[i];
+	}
+
+	//the propagator keeps its profile over [0, max_time), which needs to include the latest end of every segment
+	int max_time = 0;
+	for (int i = 0; i < start_times.size(); i++)
+	{
+		int max_length = (lengths[i].IsNull() ? 0 : constrained_satisfaction_solver_.state_.domain_manager_.GetUpperBound(lengths[i])) + length_offsets[i];
+		max_time = std::max(max_time, constrained_satisfaction_solver_.state_.domain_manager_.GetUpperBound(start_times[i]) + max_length);
+	}
+
+	PreemptiveCumulativePropagator* propagator = new PreemptiveCumulativePropagator(segments, capacity, max_time);
+	constrained_satisfaction_solver_.state_.AddPropagatorCP(propagator);
+}
+
+void ConstraintOptimisationSolver::AddObjectiveTerm(IntegerVariable variable, int64_t weight)
+{
+	if (retain_input_formula_) { input_formula_.AddObjectiveTerm(variable, weight); }
+	original_objective_function_.AddTerm(variable, weight);
+}
+
+void ConstraintOptimisationSolver::SetSolutionExchange(SolutionExchange* solution_exchange)
+{
+	solution_exchange_ = solution_exchange;
+}
+
+void ConstraintOptimisationSolver::SetWarmStartAssignment(const std::vector<int32_t>& dimacs_literals)
+{
+	ConvertDIMACSLiteralsToClause(dimacs_literals, warm_start_literals_);
+}
+
+const CompactFormula& ConstraintOptimisationSolver::GetRetainedInputFormula() const
+{
+	return input_formula_;
+}
+
+void ConstraintOptimisationSolver::RetainDIMACSIntegers(std::vector<int64_t>& dimacs_integers, bool ignore_first_integer)
+{
+	retained_clause_buffer_.clear();
+	for (int i = (ignore_first_integer ? 1 : 0); i < dimacs_integers.size() - 1; i++) //minus one since the last integer is zero
+	{
+		retained_clause_buffer_.push_back(int32_t(dimacs_integers[i]));
+	}
+}
+
+void ConstraintOptimisationSolver::ConvertDIMACSLiteralsToClause(const std::vector<int32_t>& dimacs_literals, std::vector<BooleanLiteral>& output_clause)
+{
+	output_clause.clear();
+	for (int32_t number : dimacs_literals)
+	{
+		//as in ConvertDIMASIntegersToClause, the index in the solver is one greater than the DIMACS index
+		pumpkin_assert_permanent(number != 0 && abs(number) <= num_boolean_variables_, "Error: a clause contains the variable index " + std::to_string(number) + " which has not been declared.");
+		BooleanLiteral literal = constrained_satisfaction_solver_.state_.GetEqualityLiteral(IntegerVariable(abs(number) + 1), number > 0);
+		output_clause.push_back(literal);
+	}
+}
+
+void ConstraintOptimisationSolver::AddSoftClauseInternal(std::vector<BooleanLiteral>& clause, int64_t weight)
+{
+	//even though the solver would preprocess the clause, it is important to do this before adding
+	//	this is because we need to make several decisions based on the form of the clause (see below)
+	constrained_satisfaction_solver_.state_.propagator_clausal_.PreprocessClause(clause);
+
+	//normally for each soft clause, we create a fresh ('selector') variable and add the variable to the soft clause
+	//	then we add the clause as a hard clause, and in the objective we add the selector variable
+	//	however there are a few exceptions, which will be now checked
+
+	//if the soft clause is satisfied at the root level
+	if (clause.size() > 0 && clause[0] == constrained_satisfaction_solver_.state_.true_literal_)
+	{
+		//do nothing, the clause may be ignored
+	}
+	//if the soft clause is unsatisfied at the root level
+	else if (clause.empty())
+	{
+		//add the weight of the clause as a constant to the objective, no need to add the clause itself
+		original_objective_function_.AddConstantTerm(weight);
+	}
+	//if the clause only has one literal, then we do not need to create a new selector variable
+	//	the variable in the clause will be used in the objective function
+	else if (clause.size() == 1)
+	{
+		auto lit_info = constrained_satisfaction_solver_.state_.GetLiteralInformation(clause[0]);
+		//the added term in the objective depends on the polarity of the literal
+		//	note that our objective is a sum of variables, and not a sum of literals (!)
+		if (clause[0].IsNegative())
+		{
+			//add the term weight * variable to the objective
+			original_objective_function_.AddTerm(lit_info.integer_variable, weight);
+		}
+		else
+		{
+			//add the term weight * (1 - variable) to the objective
+			original_objective_function_.AddConstantTerm(weight);
+			original_objective_function_.AddTerm(lit_info.integer_variable, -weight);
+		}
+	}
+	//otherwise we arrive at the standard case, i.e., a soft clause with at least two literals
+	else
+	{
+		IntegerVariable fresh_selector_variable = constrained_satisfaction_solver_.state_.CreateNewIntegerVariable(0, 1);
+		soft_clause_selector_created_ = true;
+		BooleanLiteral soft_literal = constrained_satisfaction_solver_.state_.GetEqualityLiteral(fresh_selector_variable, 1);
+		clause.push_back(soft_literal);
+		original_objective_function_.AddTerm(fresh_selector_variable, weight);
+		bool conflict_detected = constrained_satisfaction_solver_.state_.propagator_clausal_.AddPermanentClause(clause);
+		pumpkin_assert_permanent(!conflict_detected, "Error: unsat after adding a soft clause, strange!");
+	}
+}
+
 }//end Pumpkin namespace
@@ -8,6 +8,8 @@
 #include "../Utilities/parameter_handler.h"
 #include "../Utilities/solution_tracker.h"
 #include "../Utilities/gz_file_reader.h"
+#include "../Utilities/compact_formula.h"
+#include "../Utilities/solution_exchange.h"
 
 #include <limits>
 #include <vector>
@@ -20,6 +22,32 @@ public:
 	ConstraintOptimisationSolver(ParameterHandler& parameters);
 
 	void ReadDIMACSFile(std::string file_location);
+	//programmatic alternative to ReadDIMACSFile, useful when the formula is generated in the same process
+	//	literals follow the DIMACS convention (variables start at one, negative values are negated literals) but without the terminating zero
+	//	the variables of all clauses need to be declared using SetNumBooleanVariables before the first soft clause is added
+	void SetNumBooleanVariables(int64_t num_variables);
+	void AddHardClause(const std::vector<int32_t>& dimacs_literals);
+	void AddSoftClause(const std::vector<int32_t>& dimacs_literals, int64_t weight);
+	void FinishProgrammaticInput();
+	//integer variables and constraints that are handled by propagators instead of clauses, as in lazy clause generation
+	//	integer variables are created after the Boolean input variables, which cannot grow afterwards
+	//	the constraints can only be added before solving and need to be satisfiable at the root
+	IntegerVariable CreateIntegerVariable(int lower_bound, int upper_bound);
+	//adds the constraint \sum_i coefficients[i] * variables[i] >= right_hand_side
+	void AddLinearInequality(std::vector<IntegerVariable>& variables, std::vector<int64_t>& coefficients, int64_t right_hand_side);
+	//adds a cumulative constraint over tasks with the given start times, the strategies of the propagator are taken from the cumulative-* parameters
+	void AddCumulative(std::vector<IntegerVariable>& start_times, std::vector<int>& durations, std::vector<int>& resource_consumptions, int capacity);
+	//adds a cumulative constraint over segments of preemptive tasks, a segment occupies [start_times[i], start_times[i] + lengths[i] + length_offsets[i])
+	//	if its presence variable is one, a null presence variable makes the segment mandatory and a null length fixes its length to the offset
+	void AddPreemptiveCumulative(std::vector<IntegerVariable>& presences, std::vector<IntegerVariable>& start_times, std::vector<IntegerVariable>& lengths, std::vector<int>& length_offsets, std::vector<int>& resource_consumptions, int capacity);
+	void AddObjectiveTerm(IntegerVariable variable, int64_t weight);
+	//assignment of the input variables, given as DIMACS literals, that the initial solution is computed from
+	//	if the formula is satisfiable under the assignment the completed assignment becomes the first incumbent, otherwise it is only used as the frozen phase
+	void SetWarmStartAssignment(const std::vector<int32_t>& dimacs_literals);
+	//exchanges solutions with a concurrently running search, the exchange is not owned by the solver and needs to outlive SolveBMO
+	void SetSolutionExchange(SolutionExchange* solution_exchange);
+	//copy of the input clauses and integer constraints used to verify solutions, empty if the parameter retain-input-formula is not set
+	const CompactFormula& GetRetainedInputFormula() const;
 	//ConstraintOptimisationSolver(ProblemSpecification& problem_specification, ParameterHandler& parameters);
 	SolverOutput Solve(int64_t time_limit_in_seconds_linear_search, int64_t time_limit_in_seconds_core_guided);
 	SolverOutput SolveBMO(int64_t time_limit_in_seconds_linear_search, int64_t time_limit_in_seconds_core_guided);
@@ -41,6 +69,9 @@ public:
 	void ConvertDIMASIntegersToClause(std::vector<int64_t>& dimacs_integers, std::vector<BooleanLiteral> &output_clause, bool ignore_first_integer = false);
 	void ReadSATFileInternal(GzFileReader &file_reader);
 	void ReadMaxSATFileInternal(GzFileReader& file_reader);
+	void ConvertDIMACSLiteralsToClause(const std::vector<int32_t>& dimacs_literals, std::vector<BooleanLiteral>& output_clause);
+	void AddSoftClauseInternal(std::vector<BooleanLiteral>& clause, int64_t weight);
+	void RetainDIMACSIntegers(std::vector<int64_t>& dimacs_integers, bool ignore_first_integer);
 
 	ParameterHandler parameters_;
 	ConstraintSatisfactionSolver constrained_satisfaction_solver_;
@@ -48,6 +79,14 @@ public:
 	UpperBoundSearch linear_searcher_;
 	SolutionTracker solution_tracker_;
 	LinearFunction original_objective_function_;
+	int64_t num_boolean_variables_;
+	bool soft_clause_selector_created_, integer_variable_created_;
+	std::vector<BooleanLiteral> programmatic_clause_buffer_;
+	bool retain_input_formula_;
+	CompactFormula input_formula_;
+	std::vector<int32_t> retained_clause_buffer_;
+	std::vector<BooleanLiteral> warm_start_literals_;
+	SolutionExchange* solution_exchange_;
 };
 
 }//end Pumpkin namespace
\ No newline at end of file
@@ -101,6 +101,11 @@ std::string ConstraintSatisfactionSolver::GetStatisticsAsString()
 	return s;
 }
 
+void ConstraintSatisfactionSolver::SetInterruptCondition(std::function<bool()> interrupt_condition)
+{
+	interrupt_condition_ = interrupt_condition;
+}
+
 ConstraintSatisfactionSolver::SolverExecutionFlag ConstraintSatisfactionSolver::SolveInternal(std::vector<BooleanLiteral>& assumptions, double time_limit_in_seconds)
 {
 	InitialiseAtRoot(time_limit_in_seconds, assumptions);
@@ -111,7 +116,11 @@ ConstraintSatisfactionSolver::SolverExecutionFlag ConstraintSatisfactionSolver::
 
 		if (!propagation_status.conflict_detected)
 		{//proceed with variable selection
-			if (ShouldRestart()){ PerformRestartDuringSearch(); }
+			if (ShouldRestart())
+			{ 
+				PerformRestartDuringSearch(); 
+				if (interrupt_condition_ && interrupt_condition_()) { return SolverExecutionFlag::TIMEOUT; }
+			}
 
 			state_.IncreaseDecisionLevel();
 			BooleanLiteral next_decision_literal = GetNextDecisionLiteral();
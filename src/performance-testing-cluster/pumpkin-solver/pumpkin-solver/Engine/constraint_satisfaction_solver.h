@@ -20,6 +20,7 @@
 #include <vector>
 #include <iostream>
 #include <limits>
+#include <functional>
 
 namespace Pumpkin
 {
@@ -31,6 +32,9 @@ public:
 	SolverOutput Solve(double time_limit_in_seconds = std::numeric_limits<double>::max()); //solves the formula currently in the solver and returns a vector where the i-th entry denotes if the literal was true or false (empty vector for unsat formulas)
 	SolverOutput Solve(std::vector<BooleanLiteral> &assumptions, double time_limit_in_seconds = std::numeric_limits<double>::max());
 	
+	//the condition is checked after every restart, if it holds the search stops and reports a timeout. An empty condition never interrupts.
+	void SetInterruptCondition(std::function<bool()> interrupt_condition);
+
 	//computes a lower bound by assuming the variables take their values that minimise the function (smallest value for positive weighted integers, largest value for negative weighted integers)
 	int ComputeSimpleLowerBound(LinearFunction& function);
 
@@ -115,6 +119,7 @@ private:
 	std::vector<BooleanLiteral> assumptions_;
 	LearnedClauseMinimiser learned_clause_minimiser_;		
 	DirectlyHashedIntegerSet already_processed_;
+	std::function<bool()> interrupt_condition_;
 };
 
 inline SolverOutput ConstraintSatisfactionSolver::Solve(double time_limit_in_seconds)
@@ -7,7 +7,9 @@
 namespace Pumpkin
 {
 UpperBoundSearch::UpperBoundSearch(SolverState& state, ParameterHandler& parameters):
-	ub_prop_(0)
+	ub_prop_(0),
+	solution_exchange_(NULL),
+	num_input_variables_(0)
 {
 	use_ub_prop_ = parameters.GetBooleanParameter("ub-propagator");
 
@@ -94,10 +96,20 @@ void UpperBoundSearch::LinearSearch(ConstraintSatisfactionSolver& solver, Linear
 
 	SetValueSelectorValues(solver, objective_function, solution_tracker.GetBestSolution());
 
+	if (solution_exchange_ != NULL) { solver.SetInterruptCondition([this]() { return solution_exchange_->HasExternalSolution(); }); }
+
 	//todo check the stopping condition
 	while (stopwatch.IsWithinTimeLimit() && internal_upper_bound > internal_lower_bound && !solution_tracker.HasOptimalSolution())
 	{
 		SolverOutput output = solver.Solve(stopwatch.TimeLeftInSeconds());
+
+		//the search was interrupted for an external solution, it is treated as a solution of the solver if it improves the upper bound
+		if (!output.HasSolution() && !output.ProvenInfeasible() && solution_exchange_ != NULL && solution_exchange_->HasExternalSolution())
+		{
+			output = ImportExternalSolution(solver, stopwatch.TimeLeftInSeconds());
+			if (!output.HasSolution()) { continue; }
+		}
+
 		if (output.HasSolution())
 		{
 			runtime_assert(pseudo_boolean_encoder_.DebugCheckSatisfactionOfEncodedConstraints(output.solution));
@@ -107,6 +119,7 @@ void UpperBoundSearch::LinearSearch(ConstraintSatisfactionSolver& solver, Linear
 			internal_upper_bound = new_internal_upper_bound;
 						
 			solution_tracker.UpdateBestSolution(output.solution); //note that this update may fail if we introduced auxiliary variables during the core-guided phase: the aux variables might be set to higher values than they should, and setting them to zero does not change the original solution
+			if (solution_exchange_ != NULL) { solution_exchange_->ReportSolverSolution(output.solution, num_input_variables_, solution_tracker.UpperBound(), solution_tracker.LowerBound()); }
 
 			SetValueSelectorValues(solver, objective_function, output.solution);
 
@@ -126,9 +139,30 @@ void UpperBoundSearch::LinearSearch(ConstraintSatisfactionSolver& solver, Linear
 			break;
 		}
 	}
+	solver.SetInterruptCondition(std::function<bool()>());
 	if (ub_prop_ != NULL) { delete ub_prop_; ub_prop_ = NULL; }
 }
 
+void UpperBoundSearch::SetSolutionExchange(SolutionExchange* solution_exchange, int64_t num_input_variables)
+{
+	solution_exchange_ = solution_exchange;
+	num_input_variables_ = num_input_variables;
+}
+
+SolverOutput UpperBoundSearch::ImportExternalSolution(ConstraintSatisfactionSolver& solver, double time_limit_in_seconds)
+{
+	std::vector<int32_t> dimacs_literals = solution_exchange_->TakeExternalSolution();
+	if (dimacs_literals.empty()) { return SolverOutput(0, true, IntegerAssignmentVector(), -1, std::vector<BooleanLiteral>()); }
+
+	std::vector<BooleanLiteral> assumptions;
+	for (int32_t number : dimacs_literals)
+	{
+		//as for the input formula, the index in the solver is one greater than the DIMACS index
+		assumptions.push_back(solver.state_.GetEqualityLiteral(IntegerVariable(abs(number) + 1), number > 0));
+	}
+	return solver.Solve(assumptions, time_limit_in_seconds);
+}
+
 EncodingOutput UpperBoundSearch::EncodeInitialUpperBound(ConstraintSatisfactionSolver& solver, LinearFunction& objective_function, int64_t upper_bound, double time_limit_in_seconds)
 {
 	int64_t fixed_cost = ComputeFixedCost(solver, objective_function);
@@ -4,6 +4,7 @@
 #include "../Pseudo-Boolean Encoders/encoder_generalised_totaliser.h"
 #include "../Utilities/linear_function.h"
 #include "../Utilities/solution_tracker.h"
+#include "../Utilities/solution_exchange.h"
 #include "../Utilities/parameter_handler.h"
 #include "../Propagators/Pseudo-Boolean/counter_single_pseudo_boolean_propagator.h"
 #include "../Propagators/Linear Integer Inequality/linear_integer_inequality_propagator.h"
@@ -22,6 +23,9 @@ public:
 		double time_limit_in_seconds
 	);
 
+	//the linear search imports the external solutions of the exchange at restarts and reports its own improving solutions to it
+	void SetSolutionExchange(SolutionExchange* solution_exchange, int64_t num_input_variables);
+
 private:
 	void LinearSearch
 	(
@@ -38,6 +42,9 @@ private:
 	int64_t ComputeFixedCost(ConstraintSatisfactionSolver& solver, LinearFunction& objective_function); //the fixed cost is the constant term plus the value we get by setting all variables to their lower bound
 	void SetValueSelectorValues(ConstraintSatisfactionSolver& solver, LinearFunction& objective_function, const IntegerAssignmentVector& solution);
 
+	//completes the next external solution under the current upper bound constraint, the output has no solution if the external solution does not improve the upper bound
+	SolverOutput ImportExternalSolution(ConstraintSatisfactionSolver& solver, double time_limit_in_seconds);
+
 	IntegerAssignmentVector ComputeExtendedSolution(const IntegerAssignmentVector& reference_solution, ConstraintSatisfactionSolver& solver, double time_limit_in_seconds); //extends the input solution to assign values to the auxiliary variables that are not present in the solution but are part of the solver
 
 	int64_t GetInitialDivisionCoefficient(LinearFunction& objective_function, SolverState &state);
@@ -52,6 +59,8 @@ private:
 	//PropagatorCounterSinglePseudoBoolean *upper_bound_propagator_; //should not be deleted by the class if passed to SolverState
 	LinearIntegerInequalityPropagator *ub_prop_;
 	bool use_ub_prop_;
+	SolutionExchange* solution_exchange_; //not owned by the class, NULL if no solutions are exchanged
+	int64_t num_input_variables_;
 	std::vector<BooleanLiteral> helper_;
 	enum class VaryingResolutionStrategy { OFF, BASIC, RATIO } varying_resolution_strategy_;
 	enum class ValueSelectionStrategy { PHASE_SAVING, SOLUTION_GUIDED_SEARCH, OPTIMISTIC, OPTIMISTIC_AUX } value_selection_strategy_;
@@ -13,15 +13,18 @@ CumulativePropagator::CumulativePropagator(
 	int max_time,
 	TaskOrderingStrategy ordering_strategy,
 	IncrementalStrategy incremental_strategy,
-	LiftingStrategy lifting_strategy
+	LiftingStrategy lifting_strategy,
+	EnergeticReasoningStrategy energetic_reasoning_strategy
 ):
-	max_capacity_(max_capacity),
-	max_time_(max_time),
 	PropagatorGenericCP(1),
-	failure_detected_(false),
-	incremental_strategy_(incremental_strategy),
 	task_ordering_strategy_(ordering_strategy),
-	lifting_strategy_(lifting_strategy)
+	incremental_strategy_(incremental_strategy),
+	lifting_strategy_(lifting_strategy),
+	energetic_reasoning_strategy_(energetic_reasoning_strategy),
+	max_capacity_(max_capacity),
+	max_time_(max_time),
+	profile_(max_time),
+	failure_detected_(false)
 {
 	pumpkin_assert_simple(start_times.size() == durations.size(), "Sanity check.");
 
@@ -38,8 +41,10 @@ CumulativePropagator::CumulativePropagator(
 		tasks_.push_back(task);
 	}
 
-	compulsory_part_ = std::vector<int>(max_time_, 0);
-	is_task_active_ = std::vector<std::vector<bool> >(tasks_.size(), std::vector<bool>(max_time_, false));
+	CompulsoryPart empty_part;
+	empty_part.begin = empty_part.end = 0;
+	compulsory_parts_ = std::vector<CompulsoryPart>(tasks_.size(), empty_part);
+	is_task_to_check_ = std::vector<bool>(tasks_.size(), false);
 
 	if (ordering_strategy == TaskOrderingStrategy::ASCENDING_DURATION)
 	{
@@ -80,275 +85,33 @@ CumulativePropagator::CumulativePropagator(
 
 PropagationStatus CumulativePropagator::Propagate()
 {
-	if (incremental_strategy_ == IncrementalStrategy::OFF) { return PropagateFromScratch(); }
-
-	if (task_ordering_strategy_ == TaskOrderingStrategy::DESCENDING_CONSUMPTION_SPECIAL) { return PropagateSpecial(); }
-		
-	if (failure_detected_)
-	{
-		//extract all intervals where the the capacity of overused
-		struct Interval { int start_time; int end_time; };
-		std::vector<Interval> overused_intervals;
-		int t = 0;
-		while (t < max_time_)
-		{
-			if (compulsory_part_[t] > max_capacity_)
-			{
-				Interval failure_interval;
-				failure_interval.start_time = t;
-				do { t++; } while (t < max_time_ && compulsory_part_[t] > max_capacity_);
-				failure_interval.end_time = t;
-				overused_intervals.push_back(failure_interval);
-			}
-			t++;
-		}
-		pumpkin_assert_simple(!overused_intervals.empty(), "Sanity check.");
-		//failure - there is at least one interval where the resource consumption goes beyond the maximum capacity
-		if (!overused_intervals.empty())
-		{
-			//for now we select the middle point of the first interval; could play around with this later
-			//generate explanation; need to get tasks related to this failure; also need to choose the explanation type...
-			//could possibily remove some tasks...lift explanations...
-			//for now we do pointwise explanations
-			//set the failure clause
-			int failure_time = overused_intervals[0].start_time + (overused_intervals[0].end_time - overused_intervals[0].start_time) / 2;
-			vec<BooleanLiteral> failure_literals;
-			int total_resource_consumption = 0; //we collect only a subset of the failure tasks in order of id, possibly there are better ways here
-			for (int task_id = 0; task_id < tasks_.size() && total_resource_consumption <= max_capacity_; task_id++)
-			{
-				if (is_task_active_[task_id][failure_time])
-				{
-					Task& task = tasks_[task_id];
-
-					total_resource_consumption += task.resource_consumption;
-
-					BooleanLiteral lb_lit = state_->GetCurrentLowerBoundLiteral(task.start_time);
-					failure_literals.push(~lb_lit);
-
-					BooleanLiteral ub_lit = state_->GetCurrentUpperBoundLiteral(task.start_time);
-					failure_literals.push(~ub_lit);
-				}
-			}
-			Clause* failure_clause = clause_allocator_.CreateClause(failure_literals);
-			InitialiseFailureClause(failure_clause);
-			return true; //report conflict detected
-		}
-	}
-
-	pumpkin_assert_simple(!updated_times_.empty(), "Sanity check."); //in the current version there must be a change
-
-	//only look at the times that changed
-	//no failure, proceed with propagation
-	//	remove infeasible times from starting times of tasks
-	for (int t: updated_times_)
-	{
-		int num_tasks_for_which_we_generate_explanations = 0;
-		for (int task_id = 0; task_id < tasks_.size(); task_id++)
-		{
-			Task& task = tasks_[task_id];
+	return PropagateWithEnergeticReasoning(incremental_strategy_ == IncrementalStrategy::ON);
+}
 
-			//if the tasks are sorted by duration, then there is no point in further continuing this loop since all the other tasks may have at most this duration
-			if (task_ordering_strategy_ == TaskOrderingStrategy::DESCENDING_CONSUMPTION && compulsory_part_[t] + task.resource_consumption <= max_capacity_)
-			{
-				break;				
-			}
+PropagationStatus CumulativePropagator::PropagateFromScratch()
+{
+	return PropagateWithEnergeticReasoning(false);
+}
 
-			//if the explanation_task cannot be scheduled at this time
-			if (!is_task_active_[task_id][t] && (compulsory_part_[t] + task.resource_consumption > max_capacity_))
-			{
-				//skip if surely no propagation will be done
-				if (state_->domain_manager_.GetLowerBound(task.start_time) > t) { continue; }
-				
-				num_tasks_for_which_we_generate_explanations++;
-				
-				static vec<BooleanLiteral> explanation_literals;
-				explanation_literals.clear();
-
-				int total_resource_consumption = 0; //we collect only a subset of the tasks in order of id, possibly there are better ways here
-				for (int explanation_task_id = 0; explanation_task_id < tasks_.size() && total_resource_consumption + task.resource_consumption <= max_capacity_; explanation_task_id++)
-				{
-					if (is_task_active_[explanation_task_id][t])
-					{
-						pumpkin_assert_moderate(task_id != explanation_task_id, "Sanity check.");
-						Task& explanation_task = tasks_[explanation_task_id];						
-						total_resource_consumption += explanation_task.resource_consumption;
-
-						BooleanLiteral lb_lit = state_->GetCurrentLowerBoundLiteral(explanation_task.start_time);
-						explanation_literals.push(~lb_lit);
-		
-						BooleanLiteral ub_lit = state_->GetCurrentUpperBoundLiteral(explanation_task.start_time);
-						explanation_literals.push(~ub_lit);			
-					}
-				}
-				//t is a forbidden time, meaning that any start time that would require the explanation_task to be active at t is also forbidden
-				int forbidden_interval_start = std::max(t - task.duration + 1, 0);				
-				//for (int forbidden_t = forbidden_interval_start; forbidden_t < forbidden_interval_start + task.duration; forbidden_t++)
-				for (int forbidden_t = forbidden_interval_start; forbidden_t <= t; forbidden_t++)
-				{
-					BooleanLiteral propagated_literal = ~(state_->GetEqualityLiteral(task.start_time, forbidden_t));
-					pumpkin_assert_simple(!state_->assignments_.IsAssignedFalse(propagated_literal), "Sanity check.");//I think if it was assigned false, a conflict would have been detected, and if it was true, the lower_bound would not be propagated now
-
-					//only provide explanations if the value is in the domain
-					if (!state_->assignments_.IsAssigned(propagated_literal))
-					//if (state_.domain_manager_.IsInDomain(task.start_time, forbidden_t))
-					{
-						//set the explanation eagerly
-						//we respect the convention that the propagated literal is at the zeroth position
-						static vec<BooleanLiteral> explanation_propagation;
-						explanation_propagation.resize(explanation_literals.size() + 1);
-
-						explanation_propagation[0] = propagated_literal;
-						for (int i = 1; i < explanation_propagation.size(); i++) { explanation_propagation[i] = explanation_literals[i - 1]; }
-
-						state_->EnqueuePropagatedLiteral(propagated_literal, GetPropagatorID());
-
-						pumpkin_assert_simple(explanation_propagation.size() > 1 || state_->GetCurrentDecisionLevel() == 0, "Sanity check.");
-						map_literal_to_eager_explanation_[propagated_literal.ToPositiveInteger()] = explanation_propagation;
-					}					
-				}				
-			}
-		}
-	}
-	updated_times_.clear();
-	return false; //no conflict
+PropagationStatus CumulativePropagator::PropagateWithEnergeticReasoning(bool incremental)
+{
+	int num_reason_records = int(reason_records_.size());
+	if ((incremental ? PropagateTimeTablingIncrementally() : PropagateTimeTablingFromScratch()).conflict_detected) { return true; }
+	//energetic reasoning only runs once time-tabling has nothing left to propagate, the propagations of time-tabling call the propagator again
+	return energetic_reasoning_strategy_ == EnergeticReasoningStrategy::ON && num_reason_records == reason_records_.size() && PropagateEnergeticReasoning().conflict_detected;
 }
 
-PropagationStatus CumulativePropagator::PropagateSpecial()
+PropagationStatus CumulativePropagator::PropagateTimeTablingIncrementally()
 {
 	if (failure_detected_)
 	{
-		//extract all intervals where the the capacity of overused
-		struct Interval { int start_time; int end_time; };
-		std::vector<Interval> overused_intervals;
-		int t = 0;
-		while (t < max_time_)
-		{
-			if (compulsory_part_[t] > max_capacity_)
-			{
-				Interval failure_interval;
-				failure_interval.start_time = t;
-				do { t++; } while (t < max_time_ && compulsory_part_[t] > max_capacity_);
-				failure_interval.end_time = t;
-				overused_intervals.push_back(failure_interval);
-			}
-			t++;
-		}
-		pumpkin_assert_simple(!overused_intervals.empty(), "Sanity check.");
-		//failure - there is at least one interval where the resource consumption goes beyond the maximum capacity
-		if (!overused_intervals.empty())
-		{
-			//for now we select the middle point of the first interval; could play around with this later
-			//generate explanation; need to get tasks related to this failure; also need to choose the explanation type...
-			//could possibily remove some tasks...lift explanations...
-			//for now we do pointwise explanations
-			//set the failure clause
-			int failure_time = overused_intervals[0].start_time + (overused_intervals[0].end_time - overused_intervals[0].start_time) / 2;
-			vec<BooleanLiteral> failure_literals;
-			int total_resource_consumption = 0; //we collect only a subset of the failure tasks in order of id, possibly there are better ways here
-			for (int task_id = 0; task_id < tasks_.size() && total_resource_consumption <= max_capacity_; task_id++)
-			{
-				if (is_task_active_[task_id][failure_time])
-				{
-					Task& task = tasks_[task_id];
-					total_resource_consumption += task.resource_consumption;
-					AddTaskExplanationForTime(failure_literals, task, failure_time);
-				}
-			}
-			Clause *failure_clause = clause_allocator_.CreateClause(failure_literals);
-			InitialiseFailureClause(failure_clause);
-			return true; //report conflict detected
-		}
-	}
-
-	pumpkin_assert_simple(!updated_times_.empty(), "Sanity check."); //in the current version there must be a change
-
-	//only look at the times that changed
-	//no failure, proceed with propagation
-	//	remove infeasible times from starting times of tasks
-	for (int t : updated_times_)
-	{
-		static std::vector<int> violating_tasks;
-		violating_tasks.clear();
-
-		//collect all tasks that cannot be scheduled at the given time, that have the time current in their domain
-		//recall that in this version of the algorithm, the tasks are sorted according to their resource consumption in descending order
-		for (int task_id = 0; task_id < tasks_.size(); task_id++)
-		{
-			Task& task = tasks_[task_id];
-
-			if (compulsory_part_[t] + task.resource_consumption <= max_capacity_) { break; }
-
-			//if the explanation_task cannot be scheduled at this time
-			if (!is_task_active_[task_id][t] && (compulsory_part_[t] + task.resource_consumption > max_capacity_))				
-			{
-				//skip if surely no propagation will be done
-				if (state_->domain_manager_.GetLowerBound(task.start_time) > t) { continue; }
-
-				violating_tasks.push_back(task_id);
-			}
-		}
-		
-		//note that the tasks in violating tasks are sorted in descending order as well
-
-		static vec<BooleanLiteral> explanation_literals;
-		explanation_literals.clear();
-		explanation_literals.push(BooleanLiteral()); //dummy for the propagated literal
-		int consumption_by_explanation_tasks = 0;
-		int next_explanation_task_candidate_index = 0;
-
-		for (int violating_task_id : violating_tasks)
-		{
-			Task& violating_task = tasks_[violating_task_id];
-			//need to add more tasks to the explanation
-			while (consumption_by_explanation_tasks + violating_task.resource_consumption <= max_capacity_)
-			{
-				//find next active task
-				while (!is_task_active_[next_explanation_task_candidate_index][t])
-				{
-					pumpkin_assert_moderate(next_explanation_task_candidate_index < tasks_.size(), "Sanity check.");
-					next_explanation_task_candidate_index++;
-				}
-				pumpkin_assert_simple(next_explanation_task_candidate_index < tasks_.size(), "Sanity check.");
-
-				Task& explanation_task = tasks_[next_explanation_task_candidate_index];
-				next_explanation_task_candidate_index++;
-
-				consumption_by_explanation_tasks += explanation_task.resource_consumption;
-
-				AddTaskExplanationForTime(explanation_literals, explanation_task, t);
-			}
-
-			//generate explanation for the task....
-
-			//t is a forbidden time, meaning that any start time that would require the explanation_task to be active at t is also forbidden
-			int forbidden_interval_start = std::max(t - violating_task.duration + 1, 0);
-			//for (int forbidden_t = forbidden_interval_start; forbidden_t < forbidden_interval_start + task.duration; forbidden_t++)
-			for (int forbidden_t = forbidden_interval_start; forbidden_t <= t; forbidden_t++)
-			{
-				BooleanLiteral propagated_literal = ~(state_->GetEqualityLiteral(violating_task.start_time, forbidden_t));
-				pumpkin_assert_simple(!state_->assignments_.IsAssignedFalse(propagated_literal), "Sanity check.");//I think if it was assigned false, a conflict would have been detected, and if it was true, the lower_bound would not be propagated now
-
-				//only provide explanations if the value is in the domain
-				if (!state_->assignments_.IsAssigned(propagated_literal))
-					//if (state_.domain_manager_.IsInDomain(task.start_time, forbidden_t))
-				{
-					//set the explanation eagerly
-					//we respect the convention that the propagated literal is at the zeroth position
-					explanation_literals[0] = propagated_literal;					
-
-					state_->EnqueuePropagatedLiteral(propagated_literal, GetPropagatorID());
-
-					pumpkin_assert_simple(explanation_literals.size() > 1 || state_->GetCurrentDecisionLevel() == 0, "Sanity check.");
-					map_literal_to_eager_explanation_[propagated_literal.ToPositiveInteger()] = explanation_literals;
-				}
-			}
-		}
+		InitialiseOverloadFailureClause();
+		return true; //report conflict detected
 	}
-	updated_times_.clear();
-	return false; //no conflict
+	return PushBoundsOfAffectedTasks();
 }
 
-PropagationStatus CumulativePropagator::PropagateFromScratch()
+PropagationStatus CumulativePropagator::PropagateTimeTablingFromScratch()
 {
 	for (auto p : bound_tracker_.DebugGetCurrentBounds())
 	{
@@ -356,131 +119,19 @@ PropagationStatus CumulativePropagator::PropagateFromScratch()
 		int ub = state_->domain_manager_.GetUpperBound(p.first);
 		pumpkin_assert_simple(lb == p.second.lower_bound, "Sanity check.");
 		pumpkin_assert_simple(ub == p.second.upper_bound, "Sanity check.");
-		int m = 0;
 	}
 
-	std::vector<int> compulsory_part(max_time_, 0);
-	std::vector<std::vector<bool> > is_task_active(tasks_.size(), std::vector<bool>(max_time_, false));
-
-	//compute the current resource consumption
-	for (int task_id = 0; task_id < tasks_.size(); task_id++)
-	{
-		Task& task = tasks_[task_id];
-		int lower_bound = state_->domain_manager_.GetLowerBound(task.start_time);
-		int upper_bound = state_->domain_manager_.GetUpperBound(task.start_time);
-		int length_of_activity = std::max(lower_bound + task.duration - upper_bound, 0);
-		for (int t = lower_bound + task.duration - length_of_activity; t < lower_bound + task.duration; t++)
-		{
-			compulsory_part[t] += task.resource_consumption;
-			is_task_active[task_id][t] = true;
-		}
-	}
-	//extract all intervals where the the capacity of overused
-	struct Interval { int start_time; int end_time; };
-	std::vector<Interval> overused_intervals;
-	int t = 0;
-	while (t < max_time_)
-	{
-		if (compulsory_part[t] > max_capacity_)
-		{
-			Interval failure_interval;
-			failure_interval.start_time = t;
-			do { t++; } while (t < max_time_ && compulsory_part[t] > max_capacity_);
-			failure_interval.end_time = t;
-			overused_intervals.push_back(failure_interval);
-		}
-		t++;
-	}
-	//failure - there is at least one interval where the resource consumption goes beyond the maximum capacity
-	if (!overused_intervals.empty())
+	RecomputeProfileFromScratch();
+	if (failure_detected_)
 	{
-		//for now we select the middle point of the first interval; could play around with this later
-		//generate explanation; need to get tasks related to this failure; also need to choose the explanation type...
-		//could possibily remove some tasks...lift explanations...
-		//for now we do pointwise explanations
-		//set the failure clause
-		int failure_time = overused_intervals[0].start_time + (overused_intervals[0].end_time - overused_intervals[0].start_time) / 2;
-		vec<BooleanLiteral> failure_literals;
-		int total_resource_consumption = 0; //we collect only a subset of the failure tasks in order of id, possibly there are better ways here
-		for (int task_id = 0; task_id < tasks_.size() && total_resource_consumption <= max_capacity_; task_id++)
-		{
-			if (is_task_active[task_id][failure_time])
-			{
-				Task& task = tasks_[task_id];
-
-				total_resource_consumption += task.resource_consumption;
-
-				BooleanLiteral lb_lit = state_->GetCurrentLowerBoundLiteral(task.start_time);
-				failure_literals.push(~lb_lit);
-
-				BooleanLiteral ub_lit = state_->GetCurrentUpperBoundLiteral(task.start_time);
-				failure_literals.push(~ub_lit);
-			}
-		}
-		//runtime_assert(DebugCheckOptimalSolution(failure_literals));
-		Clause *failure_clause = clause_allocator_.CreateClause(failure_literals);
-		InitialiseFailureClause(failure_clause);
+		InitialiseOverloadFailureClause();
 		return true; //report conflict detected
 	}
 	//no failure, proceed with propagation
-	//	remove infeasible times from starting times of tasks
-	for (int t = 0; t < max_time_; t++)
+	//	push the bounds of the tasks past the times at which they do not fit
+	for (int task_id = 0; task_id < tasks_.size(); task_id++)
 	{
-		for (int task_id = 0; task_id < tasks_.size(); task_id++)
-		{
-			Task& task = tasks_[task_id];
-			//if the explanation_task cannot be scheduled at this time
-			if (!is_task_active[task_id][t]
-				&& (compulsory_part[t] + task.resource_consumption > max_capacity_ /*|| !state_.domain_manager_.IsInDomain(task.start_time, t)*/))
-				//is the !not_in_domain standard? I am not sure, probably
-			{
-				//skip if surely no propagation will be done
-				if (state_->domain_manager_.GetLowerBound(task.start_time) > t) { continue; }
-
-				vec<BooleanLiteral> explanation_literals;
-				int total_resource_consumption = 0; //we collect only a subset of the tasks in order of id, possibly there are better ways here
-				for (int explanation_task_id = 0; explanation_task_id < tasks_.size() && total_resource_consumption + task.resource_consumption <= max_capacity_; explanation_task_id++)
-				{
-					if (is_task_active[explanation_task_id][t])
-					{
-						pumpkin_assert_moderate(task_id != explanation_task_id, "Sanity check.");
-						Task& explanation_task = tasks_[explanation_task_id];
-
-						total_resource_consumption += explanation_task.resource_consumption;
-
-						BooleanLiteral lb_lit = state_->GetCurrentLowerBoundLiteral(explanation_task.start_time);
-						explanation_literals.push(~lb_lit);
-
-						BooleanLiteral ub_lit = state_->GetCurrentUpperBoundLiteral(explanation_task.start_time);
-						explanation_literals.push(~ub_lit);
-					}
-				}
-				//t is a forbidden time, meaning that any start time that would require the explanation_task to be active at t is also forbidden
-				int forbidden_interval_start = std::max(t - task.duration + 1, 0);
-				//for (int forbidden_t = forbidden_interval_start; forbidden_t < forbidden_interval_start + task.duration; forbidden_t++)
-				for (int forbidden_t = forbidden_interval_start; forbidden_t <= t; forbidden_t++)
-				{
-					BooleanLiteral propagated_literal = ~(state_->GetEqualityLiteral(task.start_time, forbidden_t));
-					pumpkin_assert_simple(!state_->assignments_.IsAssignedFalse(propagated_literal), "Sanity check.");//I think if it was assigned false, a conflict would have been detected, and if it was true, the lower_bound would not be propagated now
-
-					//only provide explanations if the value is in the domain
-					if (!state_->assignments_.IsAssigned(propagated_literal))
-					{
-						//set the explanation eagerly
-						//we respect the convention that the propagated literal is at the zeroth position
-						vec<BooleanLiteral> explanation_propagation(explanation_literals.size() + 1);
-						explanation_propagation[0] = propagated_literal;
-						for (int i = 1; i < explanation_propagation.size(); i++) { explanation_propagation[i] = explanation_literals[i - 1]; }
-
-						state_->EnqueuePropagatedLiteral(propagated_literal, GetPropagatorID());
-
-						pumpkin_assert_simple(explanation_propagation.size() > 1 || state_->GetCurrentDecisionLevel() == 0, "Sanity check.");
-						//runtime_assert(DebugCheckOptimalSolution(explanation_propagation));
-						map_literal_to_eager_explanation_[propagated_literal.ToPositiveInteger()] = explanation_propagation;
-					}
-				}
-			}
-		}
+		if (PushBounds(task_id)) { return true; }
 	}
 	return false; //no conflict
 }
@@ -489,9 +140,16 @@ void CumulativePropagator::SynchroniseInternal()
 {
 	if (state_->GetCurrentDecisionLevel() == 0){ clause_allocator_.Clear(); }
 
+	//the reasons of the propagations that were undone are no longer needed, the remaining records keep their explanation tasks
+	while (!reason_records_.empty() && reason_records_.back().decision_level > state_->GetCurrentDecisionLevel()) { reason_records_.pop_back(); }
+	explanation_tasks_.resize(reason_records_.empty() ? 0 : reason_records_.back().explanation_end);
+
+	for (int task_id : tasks_to_check_) { is_task_to_check_[task_id] = false; }
+	tasks_to_check_.clear();
+
 	if (incremental_strategy_ == IncrementalStrategy::ON)
 	{
-		updated_times_.clear();
+		updated_intervals_.clear();
 		failure_detected_ = false;
 
 		//make sure the values are properly updated in the bound tracker
@@ -509,33 +167,12 @@ void CumulativePropagator::SynchroniseInternal()
 			Task& task = tasks_[task_id];
 			pumpkin_assert_moderate(tasks_[task_id].start_time == variable_difference.variable, "Sanity check.");
 
-			int lb_old = variable_difference.bound_info.checkpoint.lower_bound;
+			//the compulsory part shrinks back to the one given by the restored bounds
 			int lb_new = variable_difference.bound_info.current.lower_bound;
-
-			int ub_old = variable_difference.bound_info.checkpoint.upper_bound;
 			int ub_new = variable_difference.bound_info.current.upper_bound;
-
-			//update by considering only a lower bound change using the old ub
-			for (int t = std::max(lb_new + task.duration, ub_old); t < lb_old + task.duration; t++)
-			{
-				//remove these times
-				pumpkin_assert_moderate(is_task_active_[task_id][t], "Sanity check.");
-				is_task_active_[task_id][t] = false;
-				compulsory_part_[t] -= task.resource_consumption;
-				pumpkin_assert_moderate(compulsory_part_[t] >= 0, "Sanity check.");
-			}
-
-			lb_old = lb_new;
-
-			//now update by considering that the lower bound was updated, and now the upper bound changed
-			for (int t = ub_old; t < std::min(ub_new, lb_new + task.duration); t++)
-			{
-				//remove these times
-				pumpkin_assert_moderate(is_task_active_[task_id][t], "Sanity check.");
-				is_task_active_[task_id][t] = false;
-				compulsory_part_[t] -= task.resource_consumption;
-				pumpkin_assert_moderate(compulsory_part_[t] >= 0, "Sanity check.");
-			}
+			pumpkin_assert_moderate(ub_new >= lb_new + task.duration || (compulsory_parts_[task_id].begin <= ub_new && lb_new + task.duration <= compulsory_parts_[task_id].end), "Sanity check.");
+			SetCompulsoryPart(task_id, ub_new, lb_new + task.duration, updated_intervals_);
+			pumpkin_assert_moderate(updated_intervals_.empty(), "Sanity check.");
 		}
 	}
 	
@@ -553,7 +190,6 @@ void CumulativePropagator::SynchroniseInternal()
 bool CumulativePropagator::DebugCheckInfeasibility(const std::vector<IntegerVariable>& relevant_variables, const SimpleBoundTracker &bounds) const
 {
 	std::vector<int> compulsory_part(max_time_, 0);
-	std::vector<std::vector<bool> > is_task_active(relevant_variables.size(), std::vector<bool>(max_time_, false));
 
 	//compute the current resource consumption considering only the relevant variables
 	for (int i = 0; i < relevant_variables.size(); i++)
@@ -565,7 +201,6 @@ bool CumulativePropagator::DebugCheckInfeasibility(const std::vector<IntegerVari
 		for (int t = lower_bound + task.duration - length_of_activity; t < lower_bound + task.duration; t++)
 		{
 			compulsory_part[t] += task.resource_consumption;
-			is_task_active[i][t] = true;
 			//if at least one time slot exceeds the capacity, report infeasible
 			if (compulsory_part[t] > max_capacity_)
 			{
@@ -573,6 +208,30 @@ bool CumulativePropagator::DebugCheckInfeasibility(const std::vector<IntegerVari
 			}
 		}
 	}
+
+	//with energetic reasoning, the intervals between the earliest starts and latest ends of the relevant tasks may be overloaded as well
+	if (energetic_reasoning_strategy_ == EnergeticReasoningStrategy::ON)
+	{
+		for (IntegerVariable begin_variable : relevant_variables)
+		{
+			for (IntegerVariable end_variable : relevant_variables)
+			{
+				int begin = bounds.GetLowerBound(begin_variable);
+				int end = bounds.GetUpperBound(end_variable) + tasks_[integer_variable_to_task_id_[end_variable.id]].duration;
+				if (end <= begin) { continue; }
+
+				int64_t energy = 0;
+				for (IntegerVariable variable : relevant_variables)
+				{
+					const Task& task = tasks_[integer_variable_to_task_id_[variable.id]];
+					int lower_bound = bounds.GetLowerBound(task.start_time);
+					int upper_bound = bounds.GetUpperBound(task.start_time);
+					energy += int64_t(task.resource_consumption) * GetMinimumOverlap(task, lower_bound, upper_bound, begin, end);
+				}
+				if (energy > int64_t(max_capacity_) * (end - begin)) { return true; }
+			}
+		}
+	}
 	return false; //no infeasibility detected
 }
 
@@ -595,69 +254,59 @@ bool CumulativePropagator::NotifyDomainChange(IntegerVariable variable)
 	//get activity length before
 	int lb_old = bound_tracker_.GetLowerBound(variable);
 	int ub_old = bound_tracker_.GetUpperBound(variable);
+	bool bounds_changed = false;
 	int length_of_activity_old = std::max(lb_old + task.duration - ub_old, 0);
 
 	//now update internal bound information
 	int lb_new = state_->domain_manager_.GetLowerBound(variable);
 	int ub_new = state_->domain_manager_.GetUpperBound(variable);
 	bound_tracker_.UpdateVariableBounds(variable, lb_new, ub_new);
+	bounds_changed = (lb_new != lb_old || ub_new != ub_old);
 
 	bound_tracker_.SaveCheckpointForVariable(variable);
 
 	//get activity length after the update
 	int length_of_activity_new = std::max(lb_new + task.duration - ub_new, 0);
 
-	//based on this difference, update compulsory part and is_task_active, and save the time as new
+	//based on this difference, update the compulsory part in the profile, and save the added times as new
 	if (incremental_strategy_ == IncrementalStrategy::ON && length_of_activity_new > length_of_activity_old)
 	{
-		if (length_of_activity_old == 0)
+		int num_updated_intervals = int(updated_intervals_.size());
+		SetCompulsoryPart(task_id, ub_new, lb_new + task.duration, updated_intervals_);
+		for (int i = num_updated_intervals; i < updated_intervals_.size(); i++)
 		{
-			for (int t = lb_new + task.duration - length_of_activity_new; t < lb_new + task.duration; t++)
-			{
-				is_task_active_[task_id][t] = true;
-				compulsory_part_[t] += task.resource_consumption;
-				failure_detected_ |= (compulsory_part_[t] > max_capacity_);
-				updated_times_.insert(t);
-			}
+			failure_detected_ |= (profile_.GetMaximum(updated_intervals_[i].begin, updated_intervals_[i].end) > max_capacity_);
 		}
-		else
-		{
-			if (lb_old < lb_new)
-			{
-				for (int t = lb_old + task.duration; t < lb_new + task.duration; t++)
-				{
-					is_task_active_[task_id][t] = true;
-					compulsory_part_[t] += task.resource_consumption;
-					failure_detected_ |= (compulsory_part_[t] > max_capacity_);
-					updated_times_.insert(t);
-				}
-				lb_old = lb_new; //needed so that the next update is done properly
-			}
-
-			if (ub_old > ub_new)
-			{
-				for (int t = ub_new; t < ub_old; t++)
-				{
-					is_task_active_[task_id][t] = true;
-					compulsory_part_[t] += task.resource_consumption;
-					failure_detected_ |= (compulsory_part_[t] > max_capacity_);
-					updated_times_.insert(t);
-				}
-			}
-		}		
 	}
 
-	//runtime_assert(DebugCompulsoryAndTaskActiveAreCorrect());
+	//runtime_assert(DebugProfileIsCorrect());
 
 	pumpkin_assert_simple(length_of_activity_new >= length_of_activity_old, "Sanity check."); //sanity check
+
+	//bounds are pushed over the windows of the earliest and latest start only, so a task whose window moved onto a time at which it does not fit
+	//	needs to be pushed further even if the compulsory part did not change
+	//	the non-incremental version does not keep the profile between calls so it propagates after every change of the bounds
+	bool push_task = bounds_changed && (incremental_strategy_ == IncrementalStrategy::OFF || HasForbiddenTimeInWindows(task_id, lb_new, ub_new));
+	if (incremental_strategy_ == IncrementalStrategy::ON && push_task && !is_task_to_check_[task_id])
+	{
+		is_task_to_check_[task_id] = true;
+		tasks_to_check_.push_back(task_id);
+	}
 	
-	return length_of_activity_new > length_of_activity_old;//only activate the propagator if there would be a change in the compulsory part
+	//energetic reasoning depends on all bounds, so any change activates the propagator if it is used
+	bool energetic_change = bounds_changed && energetic_reasoning_strategy_ == EnergeticReasoningStrategy::ON;
+	return length_of_activity_new > length_of_activity_old || push_task || energetic_change;//only activate the propagator if there would be a change in the compulsory part or the task can be pushed
 }
 
 Clause* CumulativePropagator::ExplainLiteralPropagationInternal(BooleanLiteral literal)
 {
 	pumpkin_assert_moderate(state_->assignments_.IsAssigned(literal) && state_->assignments_.GetAssignmentLevel(literal) > 0, "The propagator does not keep info on root propagations."); 
-	vec<BooleanLiteral> explanation = map_literal_to_eager_explanation_[literal.ToPositiveInteger()];
+	pumpkin_assert_moderate(literal.ToPositiveInteger() < literal_to_reason_record_.size() && literal_to_reason_record_[literal.ToPositiveInteger()] < reason_records_.size(), "Sanity check.");
+	//the explanation is constructed lazily from the reason record, we respect the convention that the propagated literal is at the zeroth position
+	static vec<BooleanLiteral> explanation;
+	explanation.clear();
+	explanation.push(literal);
+	AddReasonLiterals(explanation, reason_records_[literal_to_reason_record_[literal.ToPositiveInteger()]]);
 	Clause* clause = clause_allocator_.CreateClause(explanation);
 	return clause;
 }
@@ -687,7 +336,8 @@ PropagationStatus CumulativePropagator::InitialiseAtRootInternal()
 	//remove trivially infeasible times from the domains of the variables
 	for (Task& task : tasks_)
 	{
-		for (int t = max_time_ - task.duration + 1; t < max_time_; t++)
+		int upper_bound = state_->domain_manager_.GetUpperBound(task.start_time);
+		for (int t = max_time_ - task.duration + 1; t <= upper_bound; t++)
 		{
 			BooleanLiteral lit = ~(state_->GetEqualityLiteral(task.start_time, t));
 			bool conflict_detected = state_->propagator_clausal_.AddUnitClause(lit);
@@ -695,9 +345,15 @@ PropagationStatus CumulativePropagator::InitialiseAtRootInternal()
 		}
 	}
 
-	RecomputeCompulsoryAndIsTaskActiveFromScratch();
+	RecomputeProfileFromScratch();
 
-	if (incremental_strategy_ == IncrementalStrategy::ON) { for (int t = 0; t < max_time_; t++) { updated_times_.insert(t); } }
+	if (incremental_strategy_ == IncrementalStrategy::ON)
+	{
+		TimeInterval all_times;
+		all_times.begin = 0;
+		all_times.end = max_time_;
+		updated_intervals_.push_back(all_times);
+	}
 
 	return Propagate();
 }
@@ -742,10 +398,9 @@ bool CumulativePropagator::DebugCheckOptimalSolution(vec<BooleanLiteral>& explan
 	return false;
 }
 
-bool CumulativePropagator::DebugCompulsoryAndTaskActiveAreCorrect() const
+bool CumulativePropagator::DebugProfileIsCorrect() const
 {
-	std::vector<int> compulsory_part(compulsory_part_.size(), 0);
-	std::vector<std::vector<bool> > is_task_active(is_task_active_.size(), std::vector<bool>(max_time_, false));
+	std::vector<int> compulsory_part(max_time_, 0);
 
 	//compute the current resource consumption
 	for (int task_id = 0; task_id < tasks_.size(); task_id++)
@@ -757,48 +412,430 @@ bool CumulativePropagator::DebugCompulsoryAndTaskActiveAreCorrect() const
 		for (int t = lower_bound + task.duration - length_of_activity; t < lower_bound + task.duration; t++)
 		{
 			compulsory_part[t] += task.resource_consumption;
-			is_task_active[task_id][t] = true;			
+			pumpkin_assert_simple(IsTaskActive(task_id, t), "Sanity check.");
 		}
+		pumpkin_assert_simple(length_of_activity == 0 || compulsory_parts_[task_id].end - compulsory_parts_[task_id].begin == length_of_activity, "Sanity check.");
 	}
 
 	for (int t = 0; t < max_time_; t++)
 	{
-		pumpkin_assert_simple(compulsory_part_[t] == compulsory_part[t], "Sanity check.");
-		for (int task_id = 0; task_id < tasks_.size(); task_id++)
+		pumpkin_assert_simple(profile_.GetHeight(t) == compulsory_part[t], "Sanity check.");
+	}
+
+	return true;
+}
+
+void CumulativePropagator::RecomputeProfileFromScratch()
+{
+	profile_.Clear();
+
+	//compute the current resource consumption
+	for (int task_id = 0; task_id < tasks_.size(); task_id++)
+	{
+		Task& task = tasks_[task_id];
+		int lower_bound = state_->domain_manager_.GetLowerBound(task.start_time);
+		int upper_bound = state_->domain_manager_.GetUpperBound(task.start_time);
+		compulsory_parts_[task_id].begin = upper_bound;
+		compulsory_parts_[task_id].end = std::max(lower_bound + task.duration, upper_bound);
+		profile_.AddToRange(compulsory_parts_[task_id].begin, compulsory_parts_[task_id].end, task.resource_consumption);
+	}
+
+	failure_detected_ = (profile_.GetMaximum(0, max_time_) > max_capacity_);
+}
+
+void CumulativePropagator::InitialiseOverloadFailureClause()
+{
+	//for now we select the middle point of the first overloaded interval; could play around with this later
+	//	the explanation is pointwise, with the active tasks collected in order of id until they exceed the capacity
+	int interval_begin = profile_.FindFirstAbove(0, max_time_, max_capacity_);
+	pumpkin_assert_simple(interval_begin != -1, "Sanity check.");
+	int interval_end = interval_begin + 1;
+	while (interval_end < max_time_ && profile_.GetHeight(interval_end) > max_capacity_) { interval_end++; }
+	int failure_time = interval_begin + (interval_end - interval_begin) / 2;
+	vec<BooleanLiteral> failure_literals;
+	int total_resource_consumption = 0;
+	for (int task_id = 0; task_id < tasks_.size() && total_resource_consumption <= max_capacity_; task_id++)
+	{
+		if (IsTaskActive(task_id, failure_time))
 		{
-			pumpkin_assert_simple(is_task_active_[task_id][t] == is_task_active[task_id][t], "Sanity check.");
-			int k = 0;
+			Task& task = tasks_[task_id];
+			total_resource_consumption += task.resource_consumption;
+			AddTaskExplanationForTime(failure_literals, task, failure_time);
 		}
-		int m = 0;
 	}
+	Clause* failure_clause = clause_allocator_.CreateClause(failure_literals);
+	InitialiseFailureClause(failure_clause);
+}
 
-	return true;
+bool CumulativePropagator::IsTaskActive(int task_id, int time) const
+{
+	return compulsory_parts_[task_id].begin <= time && time < compulsory_parts_[task_id].end;
 }
 
-void CumulativePropagator::RecomputeCompulsoryAndIsTaskActiveFromScratch()
+void CumulativePropagator::SetCompulsoryPart(int task_id, int begin, int end, std::vector<TimeInterval>& added_intervals)
 {
-	failure_detected_ = false;
+	CompulsoryPart& part = compulsory_parts_[task_id];
+	end = std::max(begin, end);
+	int resource_consumption = tasks_[task_id].resource_consumption;
+	profile_.AddToRange(part.begin, part.end, -resource_consumption);
+	profile_.AddToRange(begin, end, resource_consumption);
 
-	for (int t = 0; t < max_time_; t++)
+	//the compulsory parts of a task are nested, so the new part adds at most an interval on each side of the old one
+	if (begin >= end)
+	{
+		//nothing was added
+	}
+	else if (part.begin >= part.end)
+	{
+		added_intervals.push_back({ begin, end });
+	}
+	else
 	{
-		compulsory_part_[t] = 0;
-		for(int task_id = 0; task_id < tasks_.size(); task_id++) { is_task_active_[task_id][t] = false; }
+		if (begin < part.begin) { added_intervals.push_back({ begin, part.begin }); }
+		if (part.end < end) { added_intervals.push_back({ part.end, end }); }
 	}
 
-	//compute the current resource consumption
-	for (int task_id = 0; task_id < tasks_.size(); task_id++)
+	part.begin = begin;
+	part.end = end;
+}
+
+int CumulativePropagator::FindFirstForbiddenTime(int task_id, int begin, int end) const
+{
+	int threshold = max_capacity_ - tasks_[task_id].resource_consumption;
+	const CompulsoryPart& part = compulsory_parts_[task_id];
+	//the task does not conflict with itself, so its own compulsory part is skipped
+	if (part.begin < part.end && begin < part.end && part.begin < end)
+	{
+		int time = profile_.FindFirstAbove(begin, part.begin, threshold);
+		if (time != -1) { return time; }
+		return profile_.FindFirstAbove(part.end, end, threshold);
+	}
+	return profile_.FindFirstAbove(begin, end, threshold);
+}
+
+int CumulativePropagator::FindLastForbiddenTime(int task_id, int begin, int end) const
+{
+	int threshold = max_capacity_ - tasks_[task_id].resource_consumption;
+	const CompulsoryPart& part = compulsory_parts_[task_id];
+	if (part.begin < part.end && begin < part.end && part.begin < end)
+	{
+		int time = profile_.FindLastAbove(part.end, end, threshold);
+		if (time != -1) { return time; }
+		return profile_.FindLastAbove(begin, part.begin, threshold);
+	}
+	return profile_.FindLastAbove(begin, end, threshold);
+}
+
+PropagationStatus CumulativePropagator::PushBoundsOfAffectedTasks()
+{
+	pumpkin_assert_simple(!updated_intervals_.empty() || !tasks_to_check_.empty() || energetic_reasoning_strategy_ == EnergeticReasoningStrategy::ON, "Sanity check."); //in the current version there must be a change, unless only energetic reasoning is affected
+
+	//only look at the times that changed
+	//	a task is affected if it does not fit at such a time within the window of its earliest or latest start
+	int maximum_updated_height = 0;
+	for (const TimeInterval& interval : updated_intervals_) { maximum_updated_height = std::max(maximum_updated_height, profile_.GetMaximum(interval.begin, interval.end)); }
+
+	for (int task_id = 0; task_id < tasks_.size() && !updated_intervals_.empty(); task_id++)
 	{
 		Task& task = tasks_[task_id];
+
+		//if the tasks are sorted by consumption, then there is no point in further continuing this loop since all the other tasks consume at most as much
+		if ((task_ordering_strategy_ == TaskOrderingStrategy::DESCENDING_CONSUMPTION || task_ordering_strategy_ == TaskOrderingStrategy::DESCENDING_CONSUMPTION_SPECIAL)
+			&& maximum_updated_height + task.resource_consumption <= max_capacity_)
+		{
+			break;
+		}
+
+		if (is_task_to_check_[task_id] || maximum_updated_height + task.resource_consumption <= max_capacity_) { continue; }
+
 		int lower_bound = state_->domain_manager_.GetLowerBound(task.start_time);
 		int upper_bound = state_->domain_manager_.GetUpperBound(task.start_time);
-		int length_of_activity = std::max(lower_bound + task.duration - upper_bound, 0);
-		for (int t = lower_bound + task.duration - length_of_activity; t < lower_bound + task.duration; t++)
+		for (const TimeInterval& interval : updated_intervals_)
+		{
+			if (FindFirstForbiddenTime(task_id, std::max(interval.begin, lower_bound), std::min(interval.end, lower_bound + task.duration)) != -1
+				|| FindFirstForbiddenTime(task_id, std::max(interval.begin, upper_bound), std::min(interval.end, upper_bound + task.duration)) != -1)
+			{
+				is_task_to_check_[task_id] = true;
+				tasks_to_check_.push_back(task_id);
+				break;
+			}
+		}
+	}
+	updated_intervals_.clear();
+
+	bool conflict_detected = false;
+	for (int task_id : tasks_to_check_)
+	{
+		is_task_to_check_[task_id] = false;
+		conflict_detected = conflict_detected || PushBounds(task_id);
+	}
+	tasks_to_check_.clear();
+	return conflict_detected;
+}
+
+bool CumulativePropagator::PushBounds(int task_id)
+{
+	Task& task = tasks_[task_id];
+	int lower_bound = state_->domain_manager_.GetLowerBound(task.start_time);
+	int upper_bound = state_->domain_manager_.GetUpperBound(task.start_time);
+	if (lower_bound == upper_bound) { return false; } //the task is active over its whole duration, nothing to push
+
+	//sweep over the window of the earliest start, a time t at which the task does not fit forbids the start times [t - duration + 1, t]
+	//	so the lower bound moves past t and the window grows, each step is propagated with the previous lower bound as its reason
+	int new_lower_bound = lower_bound;
+	for (int t = FindFirstForbiddenTime(task_id, lower_bound, lower_bound + task.duration); t != -1; t = FindFirstForbiddenTime(task_id, t + 1, new_lower_bound + task.duration))
+	{
+		BooleanLiteral bound_literal = state_->GetLowerBoundLiteral(task.start_time, new_lower_bound);
+		//if no start time is left, the literal [x > upper_bound] is propagated, it is false so the propagation reports the conflict
+		BooleanLiteral propagated_literal = t + 1 <= upper_bound ? state_->GetLowerBoundLiteral(task.start_time, t + 1) : ~state_->GetCurrentUpperBoundLiteral(task.start_time);
+		if (PropagateBound(propagated_literal, bound_literal, t, task_id)) { return true; }
+		new_lower_bound = t + 1;
+	}
+
+	//likewise sweep over the window of the latest start from its end
+	int new_upper_bound = upper_bound;
+	for (int t = FindLastForbiddenTime(task_id, upper_bound, upper_bound + task.duration); t != -1; t = FindLastForbiddenTime(task_id, new_upper_bound, t))
+	{
+		BooleanLiteral bound_literal = state_->GetUpperBoundLiteral(task.start_time, new_upper_bound);
+		BooleanLiteral propagated_literal = t - task.duration >= new_lower_bound ? state_->GetUpperBoundLiteral(task.start_time, t - task.duration) : ~state_->GetLowerBoundLiteral(task.start_time, new_lower_bound);
+		if (PropagateBound(propagated_literal, bound_literal, t, task_id)) { return true; }
+		new_upper_bound = t - task.duration;
+	}
+	return false;
+}
+
+bool CumulativePropagator::PropagateBound(BooleanLiteral propagated_literal, BooleanLiteral bound_literal, int time, int task_id)
+{
+	//the trail may be ahead of the snapshot, e.g., when the opposite sweep or another propagator already implied the bound
+	if (state_->assignments_.IsAssignedTrue(propagated_literal)) { return false; }
+
+	const Task& task = tasks_[task_id];
+	ReasonRecord record;
+	record.bound_literal = bound_literal;
+	record.time = time;
+	record.decision_level = state_->GetCurrentDecisionLevel();
+	//the explanation tasks of the previous record are shared if they are at the same time and leave too little capacity for this task as well
+	if (!reason_records_.empty() && reason_records_.back().time == time && reason_records_.back().resource_consumption + task.resource_consumption > max_capacity_)
+	{
+		record.resource_consumption = reason_records_.back().resource_consumption;
+		record.explanation_begin = reason_records_.back().explanation_begin;
+		record.explanation_end = reason_records_.back().explanation_end;
+	}
+	else
+	{
+		record.explanation_begin = int(explanation_tasks_.size());
+		record.resource_consumption = AddExplanationTasksForTime(time, max_capacity_ - task.resource_consumption);
+		record.explanation_end = int(explanation_tasks_.size());
+	}
+	return PropagateWithRecord(propagated_literal, record);
+}
+
+bool CumulativePropagator::PropagateWithRecord(BooleanLiteral propagated_literal, const ReasonRecord& record)
+{
+	if (state_->assignments_.IsAssignedFalse(propagated_literal))
+	{
+		vec<BooleanLiteral> failure_literals;
+		failure_literals.push(propagated_literal);
+		AddReasonLiterals(failure_literals, record);
+		explanation_tasks_.resize(reason_records_.empty() ? 0 : reason_records_.back().explanation_end);
+		Clause* failure_clause = clause_allocator_.CreateClause(failure_literals);
+		InitialiseFailureClause(failure_clause);
+		return true; //report conflict detected
+	}
+
+	state_->EnqueuePropagatedLiteral(propagated_literal, GetPropagatorID());
+	if (literal_to_reason_record_.size() <= propagated_literal.ToPositiveInteger()) { literal_to_reason_record_.resize(propagated_literal.ToPositiveInteger() + 1, -1); }
+	literal_to_reason_record_[propagated_literal.ToPositiveInteger()] = int(reason_records_.size());
+	reason_records_.push_back(record);
+	return false;
+}
+
+int CumulativePropagator::AddExplanationTasksForTime(int time, int amount)
+{
+	int total_resource_consumption = 0; //we collect only a subset of the tasks in order of id, possibly there are better ways here
+	for (int task_id = 0; task_id < tasks_.size() && total_resource_consumption <= amount; task_id++)
+	{
+		if (!IsTaskActive(task_id, time)) { continue; }
+
+		const Task& task = tasks_[task_id];
+		total_resource_consumption += task.resource_consumption;
+
+		ExplanationTask explanation_task;
+		explanation_task.task_id = task_id;
+		if (lifting_strategy_ == LiftingStrategy::ON)
+		{
+			explanation_task.lower_bound = std::max(time - task.duration + 1, 0);
+			explanation_task.upper_bound = time;
+		}
+		else
+		{
+			explanation_task.lower_bound = state_->domain_manager_.GetLowerBound(task.start_time);
+			explanation_task.upper_bound = state_->domain_manager_.GetUpperBound(task.start_time);
+		}
+		explanation_tasks_.push_back(explanation_task);
+	}
+	pumpkin_assert_moderate(total_resource_consumption > amount, "Sanity check.");
+	return total_resource_consumption;
+}
+
+void CumulativePropagator::AddReasonLiterals(vec<BooleanLiteral>& clause, const ReasonRecord& record)
+{
+	clause.push(~record.bound_literal);
+	for (int i = record.explanation_begin; i < record.explanation_end; i++)
+	{
+		const ExplanationTask& explanation_task = explanation_tasks_[i];
+		IntegerVariable start_time = tasks_[explanation_task.task_id].start_time;
+		clause.push(~state_->GetLowerBoundLiteral(start_time, explanation_task.lower_bound));
+		clause.push(~state_->GetUpperBoundLiteral(start_time, explanation_task.upper_bound));
+	}
+}
+
+bool CumulativePropagator::HasForbiddenTimeInWindows(int task_id, int lower_bound, int upper_bound) const
+{
+	const Task& task = tasks_[task_id];
+	return FindFirstForbiddenTime(task_id, lower_bound, lower_bound + task.duration) != -1
+		|| FindFirstForbiddenTime(task_id, std::max(upper_bound, lower_bound + task.duration), upper_bound + task.duration) != -1;
+}
+
+PropagationStatus CumulativePropagator::PropagateEnergeticReasoning()
+{
+	//the candidate intervals start at an earliest start and end at a latest end
+	std::vector<int> lower_bounds(tasks_.size()), upper_bounds(tasks_.size());
+	std::vector<int> interval_begins, interval_ends;
+	for (int task_id = 0; task_id < tasks_.size(); task_id++)
+	{
+		lower_bounds[task_id] = state_->domain_manager_.GetLowerBound(tasks_[task_id].start_time);
+		upper_bounds[task_id] = state_->domain_manager_.GetUpperBound(tasks_[task_id].start_time);
+		interval_begins.push_back(lower_bounds[task_id]);
+		interval_ends.push_back(upper_bounds[task_id] + tasks_[task_id].duration);
+	}
+	std::sort(interval_begins.begin(), interval_begins.end());
+	interval_begins.erase(std::unique(interval_begins.begin(), interval_begins.end()), interval_begins.end());
+	std::sort(interval_ends.begin(), interval_ends.end());
+	interval_ends.erase(std::unique(interval_ends.begin(), interval_ends.end()), interval_ends.end());
+
+	std::vector<int> minimum_overlaps(tasks_.size(), 0);
+	for (int begin : interval_begins)
+	{
+		for (int end : interval_ends)
+		{
+			if (end <= begin) { continue; }
+
+			int64_t capacity_energy = int64_t(max_capacity_) * (end - begin);
+			int64_t energy = 0;
+			int64_t maximum_energy_increase = 0; //a task can only be pushed if its energy can grow beyond the slack of the interval
+			for (int task_id = 0; task_id < tasks_.size(); task_id++)
+			{
+				const Task& task = tasks_[task_id];
+				minimum_overlaps[task_id] = GetMinimumOverlap(task, lower_bounds[task_id], upper_bounds[task_id], begin, end);
+				energy += int64_t(task.resource_consumption) * minimum_overlaps[task_id];
+				maximum_energy_increase = std::max(maximum_energy_increase, int64_t(task.resource_consumption) * (std::min(task.duration, end - begin) - minimum_overlaps[task_id]));
+			}
+
+			if (energy > capacity_energy)
+			{
+				int explanation_begin = int(explanation_tasks_.size());
+				AddExplanationTasksForInterval(begin, end, capacity_energy, -1, minimum_overlaps);
+				vec<BooleanLiteral> failure_literals;
+				for (int i = explanation_begin; i < explanation_tasks_.size(); i++)
+				{
+					IntegerVariable start_time = tasks_[explanation_tasks_[i].task_id].start_time;
+					failure_literals.push(~state_->GetLowerBoundLiteral(start_time, explanation_tasks_[i].lower_bound));
+					failure_literals.push(~state_->GetUpperBoundLiteral(start_time, explanation_tasks_[i].upper_bound));
+				}
+				explanation_tasks_.resize(explanation_begin);
+				Clause* failure_clause = clause_allocator_.CreateClause(failure_literals);
+				InitialiseFailureClause(failure_clause);
+				return true; //report conflict detected
+			}
+
+			if (capacity_energy - energy >= maximum_energy_increase) { continue; }
+
+			for (int task_id = 0; task_id < tasks_.size(); task_id++)
+			{
+				const Task& task = tasks_[task_id];
+				int lower_bound = lower_bounds[task_id];
+				int upper_bound = upper_bounds[task_id];
+				if (lower_bound == upper_bound) { continue; } //the task already has its minimum energy
+
+				//the task can overlap the interval by at most max_overlap, which forbids the start times in (begin + max_overlap - duration, end - max_overlap)
+				int64_t available_energy = capacity_energy - energy + int64_t(task.resource_consumption) * minimum_overlaps[task_id];
+				if (available_energy / task.resource_consumption >= std::min(task.duration, end - begin)) { continue; } //every start time fits
+				int max_overlap = int(available_energy / task.resource_consumption);
+				int first_forbidden = begin + max_overlap - task.duration + 1;
+				int last_forbidden = end - max_overlap - 1;
+				if (first_forbidden > last_forbidden) { continue; }
+
+				//the other tasks only need to leave less than max_overlap + 1 units of overlap for the task
+				int64_t other_energy_needed = capacity_energy - int64_t(task.resource_consumption) * (max_overlap + 1);
+
+				ReasonRecord record;
+				record.time = -1;
+				record.resource_consumption = 0;
+				record.decision_level = state_->GetCurrentDecisionLevel();
+				BooleanLiteral propagated_literal;
+				if (first_forbidden <= lower_bound && lower_bound <= last_forbidden)
+				{
+					record.bound_literal = state_->GetLowerBoundLiteral(task.start_time, lifting_strategy_ == LiftingStrategy::ON ? first_forbidden : lower_bound);
+					//if no start time is left, the false literal [x > upper_bound] is propagated, which reports the conflict
+					propagated_literal = last_forbidden + 1 <= upper_bound ? state_->GetLowerBoundLiteral(task.start_time, last_forbidden + 1) : ~state_->GetCurrentUpperBoundLiteral(task.start_time);
+				}
+				else if (first_forbidden <= upper_bound && upper_bound <= last_forbidden)
+				{
+					record.bound_literal = state_->GetUpperBoundLiteral(task.start_time, lifting_strategy_ == LiftingStrategy::ON ? last_forbidden : upper_bound);
+					propagated_literal = first_forbidden - 1 >= lower_bound ? state_->GetUpperBoundLiteral(task.start_time, first_forbidden - 1) : ~state_->GetCurrentLowerBoundLiteral(task.start_time);
+				}
+				else
+				{
+					continue;
+				}
+
+				//the trail may be ahead of the snapshot, in which case the bound may already be known
+				if (state_->assignments_.IsAssignedTrue(propagated_literal)) { continue; }
+
+				record.explanation_begin = int(explanation_tasks_.size());
+				AddExplanationTasksForInterval(begin, end, other_energy_needed, task_id, minimum_overlaps);
+				record.explanation_end = int(explanation_tasks_.size());
+				if (PropagateWithRecord(propagated_literal, record)) { return true; }
+			}
+		}
+	}
+	return false; //no conflict
+}
+
+int CumulativePropagator::GetMinimumOverlap(const Task& task, int lower_bound, int upper_bound, int begin, int end) const
+{
+	//the overlap is smallest if the task starts as early or as late as possible
+	return std::max(std::min({ end - begin, task.duration, lower_bound + task.duration - begin, end - upper_bound }), 0);
+}
+
+int64_t CumulativePropagator::AddExplanationTasksForInterval(int begin, int end, int64_t amount, int excluded_task_id, const std::vector<int>& minimum_overlaps)
+{
+	int64_t total_energy = 0; //we collect only a subset of the tasks in order of id, as for the explanations of time-tabling
+	for (int task_id = 0; task_id < tasks_.size() && total_energy <= amount; task_id++)
+	{
+		if (task_id == excluded_task_id || minimum_overlaps[task_id] == 0) { continue; }
+
+		const Task& task = tasks_[task_id];
+		total_energy += int64_t(task.resource_consumption) * minimum_overlaps[task_id];
+
+		ExplanationTask explanation_task;
+		explanation_task.task_id = task_id;
+		if (lifting_strategy_ == LiftingStrategy::ON)
+		{
+			//the weakest bounds that still give the task its minimum overlap with the interval
+			explanation_task.lower_bound = std::max(begin + minimum_overlaps[task_id] - task.duration, 0);
+			explanation_task.upper_bound = end - minimum_overlaps[task_id];
+		}
+		else
 		{
-			compulsory_part_[t] += task.resource_consumption;
-			is_task_active_[task_id][t] = true;
-			failure_detected_ |= (compulsory_part_[t] > max_capacity_);
+			explanation_task.lower_bound = state_->domain_manager_.GetLowerBound(task.start_time);
+			explanation_task.upper_bound = state_->domain_manager_.GetUpperBound(task.start_time);
 		}
+		explanation_tasks_.push_back(explanation_task);
 	}
+	pumpkin_assert_moderate(total_energy > amount, "Sanity check.");
+	return total_energy;
 }
 
 void CumulativePropagator::AddTaskExplanationForTime(vec<BooleanLiteral>& clause, const Task& task, int time) const
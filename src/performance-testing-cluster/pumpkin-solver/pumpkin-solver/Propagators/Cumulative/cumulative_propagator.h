@@ -1,14 +1,12 @@
 #pragma once
 
+#include "resource_profile.h"
 #include "../integer_variable_bound_tracker.h"
 #include "../propagator_generic_CP.h"
 #include "../../Engine/solver_state.h"
 #include "../../Utilities/standard_clause_allocator.h"
 #include "../../Utilities/integer_assignment_vector.h"
 
-#include <map>
-#include <set>
-
 namespace Pumpkin
 {
 //propagator of the cumulative constraint...todo
@@ -19,6 +17,7 @@ public:
 	enum class TaskOrderingStrategy { IN_ORDER, ASCENDING_DURATION, DESCENDING_DURATION, ASCENDING_CONSUMPTION, DESCENDING_CONSUMPTION, DESCENDING_CONSUMPTION_SPECIAL };
 	enum class IncrementalStrategy { ON, OFF };
 	enum class LiftingStrategy { ON, OFF };
+	enum class EnergeticReasoningStrategy { ON, OFF };
 	
 	CumulativePropagator
 	(
@@ -29,11 +28,11 @@ public:
 		int max_time,
 		TaskOrderingStrategy ordering_strategy,
 		IncrementalStrategy incrementality,
-		LiftingStrategy lifting_strategy
+		LiftingStrategy lifting_strategy,
+		EnergeticReasoningStrategy energetic_reasoning_strategy
 	);
 
 	PropagationStatus Propagate();
-	PropagationStatus PropagateSpecial();
 	PropagationStatus PropagateFromScratch();
 	void SynchroniseInternal();
 	bool NotifyDomainChange(IntegerVariable);
@@ -50,30 +49,79 @@ private:
 
 	void SubscribeDomainChanges();
 	PropagationStatus InitialiseAtRootInternal();
+	//time-tabling, incrementally or from scratch, followed by energetic reasoning if it is on
+	PropagationStatus PropagateWithEnergeticReasoning(bool incremental);
+	PropagationStatus PropagateTimeTablingIncrementally();
+	PropagationStatus PropagateTimeTablingFromScratch();
 
 	bool DebugCheckOptimalSolution(vec<BooleanLiteral> &explanation);
-	bool DebugCompulsoryAndTaskActiveAreCorrect() const;
-	void RecomputeCompulsoryAndIsTaskActiveFromScratch();
+	bool DebugProfileIsCorrect() const;
+	void RecomputeProfileFromScratch();
 
 	struct Task { IntegerVariable start_time; int resource_consumption, duration; };
 	void AddTaskExplanationForTime(vec<BooleanLiteral>& clause, const Task& task, int time) const;
+	void InitialiseOverloadFailureClause(); //the failure clause for a time in the first interval at which the compulsory parts exceed the capacity
+
+	//the compulsory part of a task is kept as a single rectangle in the profile, the task is active at the times [begin, end)
+	struct CompulsoryPart { int begin, end; };
+	struct TimeInterval { int begin, end; };
+	bool IsTaskActive(int task_id, int time) const;
+	//replaces the compulsory part of the task in the profile, appends the time intervals that were added to it
+	void SetCompulsoryPart(int task_id, int begin, int end, std::vector<TimeInterval>& added_intervals);
+	//the earliest or latest time in [begin, end) outside of the compulsory part of the task at which the task does not fit, -1 if there is no such time
+	int FindFirstForbiddenTime(int task_id, int begin, int end) const;
+	int FindLastForbiddenTime(int task_id, int begin, int end) const;
+
+	//filtering only pushes bounds: a time at which a task does not fit next to the compulsory parts forbids the start times that cover it
+	//	the lower bound is pushed over the forbidden times in the window of the earliest start, and likewise for the upper bound
+	//	a propagated bound is explained by the previous bound of the task, which makes it cover the time, and the tasks active at the time
+	//		the explanation tasks are recorded compactly and only converted into a clause once the solver asks for the explanation
+	struct ExplanationTask { int task_id, lower_bound, upper_bound; }; //the bounds of the start time that make the task active at the time
+	//	the records of energetic reasoning have time -1, so they are never shared
+	struct ReasonRecord { BooleanLiteral bound_literal; int time, resource_consumption, explanation_begin, explanation_end, decision_level; };
+	PropagationStatus PushBoundsOfAffectedTasks();
+	bool PushBounds(int task_id);
+	//propagates the literal with the reason record, reports a conflict if the literal is false
+	bool PropagateBound(BooleanLiteral propagated_literal, BooleanLiteral bound_literal, int time, int task_id);
+	bool PropagateWithRecord(BooleanLiteral propagated_literal, const ReasonRecord& record);
+	//adds explanation tasks active at the time with a total consumption above the amount, returns their total consumption
+	int AddExplanationTasksForTime(int time, int amount);
+	void AddReasonLiterals(vec<BooleanLiteral>& clause, const ReasonRecord& record);
+	bool HasForbiddenTimeInWindows(int task_id, int lower_bound, int upper_bound) const;
+
+	//energetic reasoning runs after time-tabling over the intervals [a, b) from an earliest start a to a latest end b
+	//	the minimum energy of a task in an interval is its consumption times its smallest overlap with the interval over its start times
+	//	an interval whose minimum energy exceeds the capacity times its length is a conflict
+	//	the start times of a task whose overlap does not fit next to the minimum energy of the other tasks are removed from the bounds
+	//		the tasks are explained by the bounds that give them their minimum overlap, or by their current bounds if lifting is off
+	PropagationStatus PropagateEnergeticReasoning();
+	int GetMinimumOverlap(const Task& task, int lower_bound, int upper_bound, int begin, int end) const;
+	//adds explanation tasks other than the excluded task whose minimum energy in [begin, end) is above the amount, returns their energy
+	int64_t AddExplanationTasksForInterval(int begin, int end, int64_t amount, int excluded_task_id, const std::vector<int>& minimum_overlaps);
 
 	TaskOrderingStrategy task_ordering_strategy_;
 	IncrementalStrategy incremental_strategy_;
 	LiftingStrategy lifting_strategy_;
+	EnergeticReasoningStrategy energetic_reasoning_strategy_;
 
 	std::vector<Task> tasks_;
 	int max_capacity_, max_time_;
 	IntegerAssignmentVector optimal_solution_;
 
+	//the profile of the compulsory parts, kept up to date incrementally or recomputed on each call if incrementality is off
+	ResourceProfile profile_;
+	std::vector<CompulsoryPart> compulsory_parts_; //[task_id] -> the rectangle of the task in the profile
+
 	//variables used for incremental computation
-	std::vector<int> compulsory_part_;
-	std::vector<std::vector<bool> > is_task_active_;
-	std::set<int> updated_times_;
+	std::vector<TimeInterval> updated_intervals_; //times at which the profile grew since the last call
+	std::vector<int> tasks_to_check_; //tasks whose window moved onto a time at which they do not fit
+	std::vector<bool> is_task_to_check_;
 	bool failure_detected_;
 	
 	StandardClauseAllocator clause_allocator_;
-	std::map<int, vec<BooleanLiteral> > map_literal_to_eager_explanation_; //lit.ToInt() -> explanation
+	std::vector<ExplanationTask> explanation_tasks_; //shared by the reason records, in the order of the records
+	std::vector<ReasonRecord> reason_records_; //records of the propagations on the trail, in the order of the trail
+	std::vector<int> literal_to_reason_record_; //lit.ToPositiveInteger() -> index in reason_records_
 	std::vector<int> integer_variable_to_task_id_;
 	IntegerVariableBoundTracker bound_tracker_;
 };
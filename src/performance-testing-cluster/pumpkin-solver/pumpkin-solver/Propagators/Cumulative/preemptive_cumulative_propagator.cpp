@@ -0,0 +1,515 @@
+#include "preemptive_cumulative_propagator.h"
+#include "../../Utilities/pumpkin_assert.h"
+
+#include <algorithm>
+
+namespace Pumpkin
+{
+PreemptiveCumulativePropagator::PreemptiveCumulativePropagator(std::vector<Segment>& segments, int max_capacity, int max_time):
+	PropagatorGenericCP(1),
+	max_capacity_(max_capacity),
+	max_time_(max_time),
+	profile_(max_time),
+	failure_detected_(false)
+{
+	for (Segment& segment : segments)
+	{
+		pumpkin_assert_simple(!segment.start_time.IsNull() && segment.length_offset >= 0 && segment.resource_consumption <= max_capacity_, "Sanity check.");
+
+		if (segment.resource_consumption == 0) { continue; }
+		if (segment.length.IsNull() && segment.length_offset == 0) { continue; }
+
+		segments_.push_back(segment);
+	}
+
+	for (int i = 0; i < segments_.size(); i++)
+	{
+		for (IntegerVariable variable : { segments_[i].presence, segments_[i].start_time, segments_[i].length })
+		{
+			if (variable.IsNull()) { continue; }
+			if (variable_to_segment_id_.size() <= variable.id) { variable_to_segment_id_.resize(variable.id + 1, -1); }
+			pumpkin_assert_simple(variable_to_segment_id_[variable.id] == -1, "Each variable can only belong to one segment.");
+			variable_to_segment_id_[variable.id] = i;
+		}
+	}
+
+	CompulsoryPart empty_part;
+	empty_part.begin = empty_part.end = 0;
+	compulsory_parts_ = std::vector<CompulsoryPart>(segments_.size(), empty_part);
+	is_segment_to_check_ = std::vector<bool>(segments_.size(), false);
+}
+
+PropagationStatus PreemptiveCumulativePropagator::Propagate()
+{
+	if (failure_detected_)
+	{
+		InitialiseOverloadFailureClause();
+		return true; //report conflict detected
+	}
+	return PushBoundsOfAffectedSegments();
+}
+
+PropagationStatus PreemptiveCumulativePropagator::PropagateFromScratch()
+{
+	RecomputeProfileFromScratch();
+	if (failure_detected_)
+	{
+		InitialiseOverloadFailureClause();
+		return true; //report conflict detected
+	}
+	//no failure, proceed with propagation
+	for (int segment_id = 0; segment_id < segments_.size(); segment_id++)
+	{
+		if (PushSegment(segment_id)) { return true; }
+	}
+	return false; //no conflict
+}
+
+void PreemptiveCumulativePropagator::SynchroniseInternal()
+{
+	if (state_->GetCurrentDecisionLevel() == 0) { clause_allocator_.Clear(); }
+
+	//the records of the propagations that were backtracked are at the end
+	while (!reason_records_.empty() && reason_records_.back().decision_level > state_->GetCurrentDecisionLevel()) { reason_records_.pop_back(); }
+	explanation_segments_.resize(reason_records_.empty() ? 0 : reason_records_.back().explanation_end);
+
+	for (int segment_id : segments_to_check_) { is_segment_to_check_[segment_id] = false; }
+	segments_to_check_.clear();
+	updated_intervals_.clear();
+	failure_detected_ = false;
+
+	//the compulsory parts shrink back to the ones they had at the current decision level
+	while (!compulsory_part_trail_.empty() && compulsory_part_trail_.back().decision_level > state_->GetCurrentDecisionLevel())
+	{
+		CompulsoryPartChange& change = compulsory_part_trail_.back();
+		SetCompulsoryPart(change.segment_id, change.begin, change.end, updated_intervals_);
+		pumpkin_assert_moderate(updated_intervals_.empty(), "Sanity check.");
+		compulsory_part_trail_.pop_back();
+	}
+}
+
+bool PreemptiveCumulativePropagator::NotifyDomainChange(IntegerVariable variable)
+{
+	pumpkin_assert_moderate(variable.id < variable_to_segment_id_.size() && variable_to_segment_id_[variable.id] != -1, "Sanity check.");
+	int segment_id = variable_to_segment_id_[variable.id];
+
+	bool compulsory_part_grew = UpdateCompulsoryPart(segment_id);
+
+	//bounds are pushed over the windows of the earliest and latest start only, so a segment whose window moved onto a time at which it does not fit
+	//	needs to be pushed further even if the profile did not change
+	bool push_segment = IsSegmentAffected(segment_id, 0, max_time_);
+	if (push_segment && !is_segment_to_check_[segment_id])
+	{
+		is_segment_to_check_[segment_id] = true;
+		segments_to_check_.push_back(segment_id);
+	}
+	return compulsory_part_grew || push_segment; //only activate the propagator if the profile changed or the segment can be pushed
+}
+
+Clause* PreemptiveCumulativePropagator::ExplainLiteralPropagationInternal(BooleanLiteral literal)
+{
+	pumpkin_assert_moderate(state_->assignments_.IsAssigned(literal) && state_->assignments_.GetAssignmentLevel(literal) > 0, "The propagator does not keep info on root propagations.");
+	pumpkin_assert_moderate(literal.ToPositiveInteger() < literal_to_reason_record_.size() && literal_to_reason_record_[literal.ToPositiveInteger()] < reason_records_.size(), "Sanity check.");
+	//the explanation is constructed lazily from the reason record, we respect the convention that the propagated literal is at the zeroth position
+	static vec<BooleanLiteral> explanation;
+	explanation.clear();
+	explanation.push(literal);
+	AddReasonLiterals(explanation, reason_records_[literal_to_reason_record_[literal.ToPositiveInteger()]]);
+	Clause* clause = clause_allocator_.CreateClause(explanation);
+	return clause;
+}
+
+bool PreemptiveCumulativePropagator::DebugCheckInfeasibility(const std::vector<IntegerVariable>& relevant_variables, const SimpleBoundTracker& bounds) const
+{
+	std::vector<bool> is_relevant(variable_to_segment_id_.size(), false);
+	for (IntegerVariable variable : relevant_variables)
+	{
+		if (variable.id < is_relevant.size()) { is_relevant[variable.id] = true; }
+	}
+
+	//compulsory parts of the segments that are present according to the relevant bounds, variables that are not relevant take their root bounds
+	//	since the literals implied at the root are the true literal, they do not make their variables relevant
+	auto get_lower_bound = [&](IntegerVariable variable)->int { return is_relevant[variable.id] ? bounds.GetLowerBound(variable) : state_->domain_manager_.GetRootLowerBound(variable); };
+	auto get_upper_bound = [&](IntegerVariable variable)->int { return is_relevant[variable.id] ? bounds.GetUpperBound(variable) : state_->domain_manager_.GetRootUpperBound(variable); };
+	std::vector<std::pair<int, int> > events;
+	for (const Segment& segment : segments_)
+	{
+		if (!segment.presence.IsNull() && get_lower_bound(segment.presence) < 1) { continue; }
+
+		int occupation = segment.length_offset;
+		if (!segment.length.IsNull()) { occupation += get_lower_bound(segment.length); }
+
+		int start = get_upper_bound(segment.start_time);
+		int end = get_lower_bound(segment.start_time) + occupation;
+		if (start >= end) { continue; }
+		events.push_back(std::make_pair(start, segment.resource_consumption));
+		events.push_back(std::make_pair(end, -segment.resource_consumption));
+	}
+	std::sort(events.begin(), events.end());
+
+	int height = 0;
+	for (int i = 0; i < events.size(); i++)
+	{
+		height += events[i].second;
+		bool last_event_at_time = (i + 1 == events.size() || events[i + 1].first != events[i].first);
+		if (last_event_at_time && height > max_capacity_) { return true; }
+	}
+	return false; //no infeasibility detected
+}
+
+void PreemptiveCumulativePropagator::SubscribeDomainChanges()
+{
+	for (Segment& segment : segments_)
+	{
+		state_->watch_list_CP_.SubscribeToLowerBoundChanges(this, segment.start_time, *state_);
+		state_->watch_list_CP_.SubscribeToUpperBoundChanges(this, segment.start_time, *state_);
+		if (!segment.length.IsNull()) { state_->watch_list_CP_.SubscribeToLowerBoundChanges(this, segment.length, *state_); }
+		if (!segment.presence.IsNull()) { state_->watch_list_CP_.SubscribeToLowerBoundChanges(this, segment.presence, *state_); }
+	}
+}
+
+PropagationStatus PreemptiveCumulativePropagator::InitialiseAtRootInternal()
+{
+	pumpkin_assert_simple(state_->GetCurrentDecisionLevel() == 0, "Can only add the preemptive cumulative propagator at the root node.");
+
+	RecomputeProfileFromScratch();
+
+	TimeInterval all_times;
+	all_times.begin = 0;
+	all_times.end = max_time_;
+	updated_intervals_.push_back(all_times);
+
+	return Propagate();
+}
+
+BooleanLiteral PreemptiveCumulativePropagator::GetPresenceLiteral(const Segment& segment) const
+{
+	if (segment.presence.IsNull()) { return state_->true_literal_; }
+	return state_->GetLowerBoundLiteral(segment.presence, 1);
+}
+
+int PreemptiveCumulativePropagator::GetMinimumOccupation(const Segment& segment) const
+{
+	if (segment.length.IsNull()) { return segment.length_offset; }
+	return state_->domain_manager_.GetLowerBound(segment.length) + segment.length_offset;
+}
+
+void PreemptiveCumulativePropagator::RecomputeProfileFromScratch()
+{
+	profile_.Clear();
+
+	for (int segment_id = 0; segment_id < segments_.size(); segment_id++)
+	{
+		Segment& segment = segments_[segment_id];
+		CompulsoryPart& part = compulsory_parts_[segment_id];
+		part.begin = part.end = 0;
+		if (!state_->assignments_.IsAssignedTrue(GetPresenceLiteral(segment))) { continue; }
+
+		part.begin = state_->domain_manager_.GetUpperBound(segment.start_time);
+		part.end = std::max(state_->domain_manager_.GetLowerBound(segment.start_time) + GetMinimumOccupation(segment), part.begin);
+		profile_.AddToRange(part.begin, part.end, segment.resource_consumption);
+	}
+
+	failure_detected_ = (profile_.GetMaximum(0, max_time_) > max_capacity_);
+}
+
+bool PreemptiveCumulativePropagator::UpdateCompulsoryPart(int segment_id)
+{
+	Segment& segment = segments_[segment_id];
+	if (!state_->assignments_.IsAssignedTrue(GetPresenceLiteral(segment))) { return false; }
+
+	int begin = state_->domain_manager_.GetUpperBound(segment.start_time);
+	int end = state_->domain_manager_.GetLowerBound(segment.start_time) + GetMinimumOccupation(segment);
+	CompulsoryPart& part = compulsory_parts_[segment_id];
+	pumpkin_assert_simple(std::max(end - begin, 0) >= part.end - part.begin, "Sanity check.");
+	if (end - begin <= part.end - part.begin) { return false; }
+
+	//the previous part only needs to be restored if the change is undone
+	if (state_->GetCurrentDecisionLevel() > 0)
+	{
+		CompulsoryPartChange change;
+		change.segment_id = segment_id;
+		change.begin = part.begin;
+		change.end = part.end;
+		change.decision_level = state_->GetCurrentDecisionLevel();
+		compulsory_part_trail_.push_back(change);
+	}
+
+	int num_updated_intervals = int(updated_intervals_.size());
+	SetCompulsoryPart(segment_id, begin, end, updated_intervals_);
+	for (int i = num_updated_intervals; i < updated_intervals_.size(); i++)
+	{
+		failure_detected_ |= (profile_.GetMaximum(updated_intervals_[i].begin, updated_intervals_[i].end) > max_capacity_);
+	}
+	return true;
+}
+
+void PreemptiveCumulativePropagator::SetCompulsoryPart(int segment_id, int begin, int end, std::vector<TimeInterval>& added_intervals)
+{
+	CompulsoryPart& part = compulsory_parts_[segment_id];
+	end = std::max(begin, end);
+	int resource_consumption = segments_[segment_id].resource_consumption;
+	profile_.AddToRange(part.begin, part.end, -resource_consumption);
+	profile_.AddToRange(begin, end, resource_consumption);
+
+	//the compulsory parts of a segment are nested, so the new part adds at most an interval on each side of the old one
+	if (begin >= end)
+	{
+		//nothing was added
+	}
+	else if (part.begin >= part.end)
+	{
+		added_intervals.push_back({ begin, end });
+	}
+	else
+	{
+		if (begin < part.begin) { added_intervals.push_back({ begin, part.begin }); }
+		if (part.end < end) { added_intervals.push_back({ part.end, end }); }
+	}
+
+	part.begin = begin;
+	part.end = end;
+}
+
+bool PreemptiveCumulativePropagator::IsSegmentActive(int segment_id, int time) const
+{
+	return compulsory_parts_[segment_id].begin <= time && time < compulsory_parts_[segment_id].end;
+}
+
+int PreemptiveCumulativePropagator::FindFirstForbiddenTime(int segment_id, int begin, int end) const
+{
+	int threshold = max_capacity_ - segments_[segment_id].resource_consumption;
+	const CompulsoryPart& part = compulsory_parts_[segment_id];
+	//the segment does not conflict with itself, so its own compulsory part is skipped
+	if (part.begin < part.end && begin < part.end && part.begin < end)
+	{
+		int time = profile_.FindFirstAbove(begin, part.begin, threshold);
+		if (time != -1) { return time; }
+		return profile_.FindFirstAbove(part.end, end, threshold);
+	}
+	return profile_.FindFirstAbove(begin, end, threshold);
+}
+
+int PreemptiveCumulativePropagator::FindLastForbiddenTime(int segment_id, int begin, int end) const
+{
+	int threshold = max_capacity_ - segments_[segment_id].resource_consumption;
+	const CompulsoryPart& part = compulsory_parts_[segment_id];
+	if (part.begin < part.end && begin < part.end && part.begin < end)
+	{
+		int time = profile_.FindLastAbove(part.end, end, threshold);
+		if (time != -1) { return time; }
+		return profile_.FindLastAbove(begin, part.begin, threshold);
+	}
+	return profile_.FindLastAbove(begin, end, threshold);
+}
+
+void PreemptiveCumulativePropagator::InitialiseOverloadFailureClause()
+{
+	//pointwise explanation at the middle point of the first overloaded interval, with the active segments collected in order of id
+	int interval_begin = profile_.FindFirstAbove(0, max_time_, max_capacity_);
+	pumpkin_assert_simple(interval_begin != -1, "Sanity check.");
+	int interval_end = interval_begin + 1;
+	while (interval_end < max_time_ && profile_.GetHeight(interval_end) > max_capacity_) { interval_end++; }
+	int failure_time = interval_begin + (interval_end - interval_begin) / 2;
+
+	int explanation_begin = int(explanation_segments_.size());
+	AddExplanationSegmentsForTime(failure_time, max_capacity_);
+	vec<BooleanLiteral> failure_literals;
+	for (int i = explanation_begin; i < explanation_segments_.size(); i++) { AddExplanationSegmentLiterals(failure_literals, explanation_segments_[i]); }
+	explanation_segments_.resize(explanation_begin);
+	Clause* failure_clause = clause_allocator_.CreateClause(failure_literals);
+	InitialiseFailureClause(failure_clause);
+}
+
+bool PreemptiveCumulativePropagator::IsSegmentAffected(int segment_id, int begin, int end) const
+{
+	const Segment& segment = segments_[segment_id];
+	BooleanLiteral presence_literal = GetPresenceLiteral(segment);
+	if (state_->assignments_.IsAssignedFalse(presence_literal)) { return false; }
+
+	int lower_bound = state_->domain_manager_.GetLowerBound(segment.start_time);
+	int upper_bound = state_->domain_manager_.GetUpperBound(segment.start_time);
+	int occupation = GetMinimumOccupation(segment);
+	if (occupation == 0) { return false; }
+
+	if (state_->assignments_.IsAssignedTrue(presence_literal))
+	{
+		if (lower_bound == upper_bound) { return false; } //the segment is active over its whole occupation, nothing to push
+		return FindFirstForbiddenTime(segment_id, std::max(begin, lower_bound), std::min(end, lower_bound + occupation)) != -1
+			|| FindFirstForbiddenTime(segment_id, std::max({ begin, upper_bound, lower_bound + occupation }), std::min(end, upper_bound + occupation)) != -1;
+	}
+	return FindFirstForbiddenTime(segment_id, std::max(begin, upper_bound), std::min(end, lower_bound + occupation)) != -1;
+}
+
+PropagationStatus PreemptiveCumulativePropagator::PushBoundsOfAffectedSegments()
+{
+	//only look at the times that changed
+	//	a segment is affected if it does not fit at such a time within the window of its earliest or latest start
+	int maximum_updated_height = 0;
+	for (const TimeInterval& interval : updated_intervals_) { maximum_updated_height = std::max(maximum_updated_height, profile_.GetMaximum(interval.begin, interval.end)); }
+
+	for (int segment_id = 0; segment_id < segments_.size() && !updated_intervals_.empty(); segment_id++)
+	{
+		if (is_segment_to_check_[segment_id] || maximum_updated_height + segments_[segment_id].resource_consumption <= max_capacity_) { continue; }
+
+		for (const TimeInterval& interval : updated_intervals_)
+		{
+			if (IsSegmentAffected(segment_id, interval.begin, interval.end))
+			{
+				is_segment_to_check_[segment_id] = true;
+				segments_to_check_.push_back(segment_id);
+				break;
+			}
+		}
+	}
+	updated_intervals_.clear();
+
+	bool conflict_detected = false;
+	for (int segment_id : segments_to_check_)
+	{
+		is_segment_to_check_[segment_id] = false;
+		conflict_detected = conflict_detected || PushSegment(segment_id);
+	}
+	segments_to_check_.clear();
+	return conflict_detected;
+}
+
+bool PreemptiveCumulativePropagator::PushSegment(int segment_id)
+{
+	Segment& segment = segments_[segment_id];
+	BooleanLiteral presence_literal = GetPresenceLiteral(segment);
+	if (state_->assignments_.IsAssignedFalse(presence_literal)) { return false; }
+
+	int lower_bound = state_->domain_manager_.GetLowerBound(segment.start_time);
+	int upper_bound = state_->domain_manager_.GetUpperBound(segment.start_time);
+	int occupation = GetMinimumOccupation(segment);
+	if (occupation == 0) { return false; }
+
+	if (!state_->assignments_.IsAssignedTrue(presence_literal))
+	{
+		//the segment surely covers [upper_bound, lower_bound + occupation) if it is present
+		int time = FindFirstForbiddenTime(segment_id, upper_bound, lower_bound + occupation);
+		if (time == -1) { return false; }
+		//lifted explanation: any start time in [time - occupation + 1, time] covers the time
+		BooleanLiteral lower_bound_literal = state_->GetLowerBoundLiteral(segment.start_time, std::max(time - occupation + 1, 0));
+		BooleanLiteral upper_bound_literal = state_->GetUpperBoundLiteral(segment.start_time, time);
+		return PropagateForTime(~presence_literal, segment_id, BooleanLiteral::UndefinedLiteral(), lower_bound_literal, upper_bound_literal, time);
+	}
+
+	if (lower_bound == upper_bound) { return false; } //the segment is active over its whole occupation, nothing to push
+	BooleanLiteral own_presence_literal = segment.presence.IsNull() ? BooleanLiteral::UndefinedLiteral() : presence_literal;
+
+	//sweep over the window of the earliest start, a time t at which the segment does not fit forbids the start times [t - occupation + 1, t]
+	//	so the lower bound moves past t and the window grows, a step is explained by the lifted bound if the snapshot implies it and by the previous lower bound otherwise
+	int new_lower_bound = lower_bound;
+	for (int t = FindFirstForbiddenTime(segment_id, lower_bound, lower_bound + occupation); t != -1; t = FindFirstForbiddenTime(segment_id, t + 1, new_lower_bound + occupation))
+	{
+		int lifted_bound = std::max(t - occupation + 1, 0);
+		BooleanLiteral bound_literal = state_->GetLowerBoundLiteral(segment.start_time, lifted_bound <= lower_bound ? lifted_bound : new_lower_bound);
+		//if no start time is left, the literal [x > upper_bound] is propagated, it is false so the propagation reports the conflict
+		BooleanLiteral propagated_literal = t + 1 <= upper_bound ? state_->GetLowerBoundLiteral(segment.start_time, t + 1) : ~state_->GetCurrentUpperBoundLiteral(segment.start_time);
+		if (PropagateForTime(propagated_literal, segment_id, own_presence_literal, bound_literal, BooleanLiteral::UndefinedLiteral(), t)) { return true; }
+		new_lower_bound = t + 1;
+	}
+
+	//likewise sweep over the window of the latest start from its end
+	int new_upper_bound = upper_bound;
+	for (int t = FindLastForbiddenTime(segment_id, upper_bound, upper_bound + occupation); t != -1; t = FindLastForbiddenTime(segment_id, new_upper_bound, t))
+	{
+		BooleanLiteral bound_literal = state_->GetUpperBoundLiteral(segment.start_time, t >= upper_bound ? t : new_upper_bound);
+		BooleanLiteral propagated_literal = t - occupation >= new_lower_bound ? state_->GetUpperBoundLiteral(segment.start_time, t - occupation) : ~state_->GetLowerBoundLiteral(segment.start_time, new_lower_bound);
+		if (PropagateForTime(propagated_literal, segment_id, own_presence_literal, BooleanLiteral::UndefinedLiteral(), bound_literal, t)) { return true; }
+		new_upper_bound = t - occupation;
+	}
+	return false;
+}
+
+bool PreemptiveCumulativePropagator::PropagateForTime(BooleanLiteral propagated_literal, int segment_id, BooleanLiteral presence_literal, BooleanLiteral lower_bound_literal, BooleanLiteral upper_bound_literal, int time)
+{
+	//the trail may be ahead of the snapshot, e.g., when the opposite sweep or another propagator already implied the literal
+	if (state_->assignments_.IsAssignedTrue(propagated_literal)) { return false; }
+
+	const Segment& segment = segments_[segment_id];
+	ReasonRecord record;
+	record.presence_literal = presence_literal;
+	record.lower_bound_literal = lower_bound_literal;
+	record.upper_bound_literal = upper_bound_literal;
+	record.length_literal = segment.length.IsNull() ? BooleanLiteral::UndefinedLiteral() : state_->GetCurrentLowerBoundLiteral(segment.length);
+	record.time = time;
+	record.decision_level = state_->GetCurrentDecisionLevel();
+	//the explanation segments of the previous record are shared if they are at the same time and leave too little capacity for this segment as well
+	if (!reason_records_.empty() && reason_records_.back().time == time && reason_records_.back().resource_consumption + segment.resource_consumption > max_capacity_)
+	{
+		record.resource_consumption = reason_records_.back().resource_consumption;
+		record.explanation_begin = reason_records_.back().explanation_begin;
+		record.explanation_end = reason_records_.back().explanation_end;
+	}
+	else
+	{
+		record.explanation_begin = int(explanation_segments_.size());
+		record.resource_consumption = AddExplanationSegmentsForTime(time, max_capacity_ - segment.resource_consumption);
+		record.explanation_end = int(explanation_segments_.size());
+	}
+	return PropagateWithRecord(propagated_literal, record);
+}
+
+bool PreemptiveCumulativePropagator::PropagateWithRecord(BooleanLiteral propagated_literal, const ReasonRecord& record)
+{
+	if (state_->assignments_.IsAssignedFalse(propagated_literal))
+	{
+		vec<BooleanLiteral> failure_literals;
+		failure_literals.push(propagated_literal);
+		AddReasonLiterals(failure_literals, record);
+		explanation_segments_.resize(reason_records_.empty() ? 0 : reason_records_.back().explanation_end);
+		Clause* failure_clause = clause_allocator_.CreateClause(failure_literals);
+		InitialiseFailureClause(failure_clause);
+		return true; //report conflict detected
+	}
+
+	state_->EnqueuePropagatedLiteral(propagated_literal, GetPropagatorID());
+	if (literal_to_reason_record_.size() <= propagated_literal.ToPositiveInteger()) { literal_to_reason_record_.resize(propagated_literal.ToPositiveInteger() + 1, -1); }
+	literal_to_reason_record_[propagated_literal.ToPositiveInteger()] = int(reason_records_.size());
+	reason_records_.push_back(record);
+	return false;
+}
+
+int PreemptiveCumulativePropagator::AddExplanationSegmentsForTime(int time, int amount)
+{
+	int total_resource_consumption = 0; //we collect only a subset of the segments in order of id, possibly there are better ways here
+	for (int segment_id = 0; segment_id < segments_.size() && total_resource_consumption <= amount; segment_id++)
+	{
+		if (!IsSegmentActive(segment_id, time)) { continue; }
+
+		const Segment& segment = segments_[segment_id];
+		total_resource_consumption += segment.resource_consumption;
+
+		//lifted explanation: any start time in [time - occupation + 1, time] covers the time
+		ExplanationSegment explanation_segment;
+		explanation_segment.segment_id = segment_id;
+		explanation_segment.lower_bound = std::max(time - GetMinimumOccupation(segment) + 1, 0);
+		explanation_segment.upper_bound = time;
+		explanation_segment.minimum_length = segment.length.IsNull() ? 0 : state_->domain_manager_.GetLowerBound(segment.length);
+		explanation_segments_.push_back(explanation_segment);
+	}
+	pumpkin_assert_moderate(total_resource_consumption > amount, "Sanity check.");
+	return total_resource_consumption;
+}
+
+void PreemptiveCumulativePropagator::AddReasonLiterals(vec<BooleanLiteral>& clause, const ReasonRecord& record) const
+{
+	for (BooleanLiteral literal : { record.presence_literal, record.lower_bound_literal, record.upper_bound_literal, record.length_literal })
+	{
+		if (!literal.IsUndefined()) { clause.push(~literal); }
+	}
+	for (int i = record.explanation_begin; i < record.explanation_end; i++) { AddExplanationSegmentLiterals(clause, explanation_segments_[i]); }
+}
+
+void PreemptiveCumulativePropagator::AddExplanationSegmentLiterals(vec<BooleanLiteral>& clause, const ExplanationSegment& explanation_segment) const
+{
+	const Segment& segment = segments_[explanation_segment.segment_id];
+	if (!segment.presence.IsNull()) { clause.push(~state_->GetLowerBoundLiteral(segment.presence, 1)); }
+	clause.push(~state_->GetLowerBoundLiteral(segment.start_time, explanation_segment.lower_bound));
+	clause.push(~state_->GetUpperBoundLiteral(segment.start_time, explanation_segment.upper_bound));
+	if (!segment.length.IsNull()) { clause.push(~state_->GetLowerBoundLiteral(segment.length, explanation_segment.minimum_length)); }
+}
+}
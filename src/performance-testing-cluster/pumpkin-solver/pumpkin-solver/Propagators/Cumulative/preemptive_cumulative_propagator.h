@@ -0,0 +1,104 @@
+#pragma once
+
+#include "resource_profile.h"
+#include "../propagator_generic_CP.h"
+#include "../../Engine/solver_state.h"
+#include "../../Utilities/standard_clause_allocator.h"
+
+#include <vector>
+
+namespace Pumpkin
+{
+//propagator of the cumulative constraint over the segments of preemptive tasks
+//	a segment is optional, it only uses the resource if its presence variable is one
+//	a segment has a variable length and occupies the resource for its length plus a fixed offset
+//		the offset is the setup time for resumed segments, and the whole duration for segments of fixed length
+//	filtering is done by time-tabling on the compulsory parts of the present segments:
+//		-a time at which the compulsory parts exceed the capacity is a conflict
+//		-the start time of a present segment is pushed past the times at which its minimum occupation does not fit
+//		-a segment that would overload the resource at a time it surely covers is made absent
+//	as in the cumulative propagator, the profile is kept up to date incrementally and only the segments affected by a change are pushed
+//	every variable belongs to a single segment
+class PreemptiveCumulativePropagator : public PropagatorGenericCP
+{
+public:
+	struct Segment
+	{
+		IntegerVariable presence; //null for segments that are always present
+		IntegerVariable start_time;
+		IntegerVariable length; //null for segments of fixed length, which only occupy the offset
+		int length_offset, resource_consumption;
+	};
+
+	//the profile covers the times [0, max_time), which needs to include the latest end of every segment
+	PreemptiveCumulativePropagator(std::vector<Segment>& segments, int max_capacity, int max_time);
+
+	PropagationStatus Propagate();
+	PropagationStatus PropagateFromScratch();
+	void SynchroniseInternal();
+	bool NotifyDomainChange(IntegerVariable);
+
+private:
+	Clause* ExplainLiteralPropagationInternal(BooleanLiteral);
+	bool DebugCheckInfeasibility(const std::vector<IntegerVariable>& relevant_variables, const SimpleBoundTracker& bounds) const;
+	void SubscribeDomainChanges();
+	PropagationStatus InitialiseAtRootInternal();
+
+	BooleanLiteral GetPresenceLiteral(const Segment& segment) const;
+	int GetMinimumOccupation(const Segment& segment) const;
+
+	//the compulsory part of a present segment is [upper bound, lower bound + minimum occupation), it only grows until the solver backtracks
+	//	the parts that were replaced are kept on a trail and restored when the solver backtracks past their decision level
+	struct CompulsoryPart { int begin, end; };
+	struct CompulsoryPartChange { int segment_id, begin, end, decision_level; };
+	struct TimeInterval { int begin, end; };
+	void RecomputeProfileFromScratch();
+	bool UpdateCompulsoryPart(int segment_id); //returns true if the compulsory part grew
+	//replaces the compulsory part of the segment in the profile, appends the time intervals that were added to it
+	void SetCompulsoryPart(int segment_id, int begin, int end, std::vector<TimeInterval>& added_intervals);
+	bool IsSegmentActive(int segment_id, int time) const;
+	//the earliest or latest time in [begin, end) outside of the compulsory part of the segment at which it does not fit, -1 if there is no such time
+	int FindFirstForbiddenTime(int segment_id, int begin, int end) const;
+	int FindLastForbiddenTime(int segment_id, int begin, int end) const;
+	void InitialiseOverloadFailureClause(); //the failure clause for the first time at which the compulsory parts exceed the capacity
+
+	//a segment is affected by a forbidden time in [begin, end) that lies in the window of the earliest or latest start of a present segment,
+	//	or in the times an optional segment surely covers if it is present
+	bool IsSegmentAffected(int segment_id, int begin, int end) const;
+	PropagationStatus PushBoundsOfAffectedSegments();
+	//pushes both bounds of a present segment over the forbidden times in one sweep each, or makes an optional segment absent
+	bool PushSegment(int segment_id);
+
+	//a propagation is explained by the own literals of the segment, which make it cover the time, and the segments active at the time
+	//	the explanation segments are recorded compactly and only converted into a clause once the solver asks for the explanation
+	//	own literals that are undefined are not part of the explanation
+	struct ExplanationSegment { int segment_id, lower_bound, upper_bound, minimum_length; };
+	struct ReasonRecord { BooleanLiteral presence_literal, lower_bound_literal, upper_bound_literal, length_literal; int time, resource_consumption, explanation_begin, explanation_end, decision_level; };
+	//propagates the literal because the segment would cover the time at which it does not fit, reports a conflict if the literal is false
+	bool PropagateForTime(BooleanLiteral propagated_literal, int segment_id, BooleanLiteral presence_literal, BooleanLiteral lower_bound_literal, BooleanLiteral upper_bound_literal, int time);
+	bool PropagateWithRecord(BooleanLiteral propagated_literal, const ReasonRecord& record);
+	//adds explanation segments active at the time with a total consumption above the amount, returns their total consumption
+	int AddExplanationSegmentsForTime(int time, int amount);
+	void AddReasonLiterals(vec<BooleanLiteral>& clause, const ReasonRecord& record) const;
+	void AddExplanationSegmentLiterals(vec<BooleanLiteral>& clause, const ExplanationSegment& explanation_segment) const;
+
+	std::vector<Segment> segments_;
+	int max_capacity_, max_time_;
+	std::vector<int> variable_to_segment_id_;
+
+	ResourceProfile profile_;
+	std::vector<CompulsoryPart> compulsory_parts_; //[segment_id] -> the rectangle of the segment in the profile
+	std::vector<CompulsoryPartChange> compulsory_part_trail_; //previous compulsory parts, in the order of the changes
+
+	//variables used for incremental computation
+	std::vector<TimeInterval> updated_intervals_; //times at which the profile grew since the last call
+	std::vector<int> segments_to_check_; //segments whose window moved onto a time at which they do not fit
+	std::vector<bool> is_segment_to_check_;
+	bool failure_detected_;
+
+	StandardClauseAllocator clause_allocator_;
+	std::vector<ExplanationSegment> explanation_segments_; //shared by the reason records, in the order of the records
+	std::vector<ReasonRecord> reason_records_; //records of the propagations on the trail, in the order of the trail
+	std::vector<int> literal_to_reason_record_; //lit.ToPositiveInteger() -> index in reason_records_
+};
+}
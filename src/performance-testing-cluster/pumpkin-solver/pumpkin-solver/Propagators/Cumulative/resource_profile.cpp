@@ -0,0 +1,116 @@
+#include "resource_profile.h"
+#include "../../Utilities/pumpkin_assert.h"
+
+#include <algorithm>
+#include <limits>
+
+namespace Pumpkin
+{
+ResourceProfile::ResourceProfile(int num_times):
+	num_times_(num_times),
+	maximum_(4 * std::max(num_times, 1), 0),
+	addition_(4 * std::max(num_times, 1), 0)
+{
+	pumpkin_assert_simple(num_times >= 0, "Sanity check.");
+}
+
+void ResourceProfile::AddToRange(int begin, int end, int amount)
+{
+	begin = std::max(begin, 0);
+	end = std::min(end, num_times_);
+	if (begin >= end || amount == 0) { return; }
+	AddToRangeInternal(1, 0, num_times_, begin, end, amount);
+}
+
+void ResourceProfile::Clear()
+{
+	std::fill(maximum_.begin(), maximum_.end(), 0);
+	std::fill(addition_.begin(), addition_.end(), 0);
+}
+
+int ResourceProfile::GetHeight(int time) const
+{
+	pumpkin_assert_moderate(0 <= time && time < num_times_, "Sanity check.");
+	return GetMaximum(time, time + 1);
+}
+
+int ResourceProfile::GetMaximum(int begin, int end) const
+{
+	begin = std::max(begin, 0);
+	end = std::min(end, num_times_);
+	if (begin >= end) { return 0; }
+	return GetMaximumInternal(1, 0, num_times_, begin, end);
+}
+
+int ResourceProfile::FindFirstAbove(int begin, int end, int threshold) const
+{
+	begin = std::max(begin, 0);
+	end = std::min(end, num_times_);
+	if (begin >= end) { return -1; }
+	return FindFirstAboveInternal(1, 0, num_times_, begin, end, threshold);
+}
+
+int ResourceProfile::FindLastAbove(int begin, int end, int threshold) const
+{
+	begin = std::max(begin, 0);
+	end = std::min(end, num_times_);
+	if (begin >= end) { return -1; }
+	return FindLastAboveInternal(1, 0, num_times_, begin, end, threshold);
+}
+
+int ResourceProfile::NumTimes() const
+{
+	return num_times_;
+}
+
+void ResourceProfile::AddToRangeInternal(int node, int node_begin, int node_end, int begin, int end, int amount)
+{
+	if (end <= node_begin || node_end <= begin) { return; }
+
+	if (begin <= node_begin && node_end <= end)
+	{
+		maximum_[node] += amount;
+		addition_[node] += amount;
+		return;
+	}
+
+	int middle = node_begin + (node_end - node_begin) / 2;
+	AddToRangeInternal(2 * node, node_begin, middle, begin, end, amount);
+	AddToRangeInternal(2 * node + 1, middle, node_end, begin, end, amount);
+	maximum_[node] = std::max(maximum_[2 * node], maximum_[2 * node + 1]) + addition_[node];
+}
+
+int ResourceProfile::GetMaximumInternal(int node, int node_begin, int node_end, int begin, int end) const
+{
+	if (end <= node_begin || node_end <= begin) { return std::numeric_limits<int>::min(); }
+	if (begin <= node_begin && node_end <= end) { return maximum_[node]; }
+
+	int middle = node_begin + (node_end - node_begin) / 2;
+	int maximum = std::max(GetMaximumInternal(2 * node, node_begin, middle, begin, end), GetMaximumInternal(2 * node + 1, middle, node_end, begin, end));
+	return maximum + addition_[node];
+}
+
+int ResourceProfile::FindFirstAboveInternal(int node, int node_begin, int node_end, int begin, int end, int threshold) const
+{
+	//the threshold is relative to the amounts added above the node
+	if (end <= node_begin || node_end <= begin || maximum_[node] <= threshold) { return -1; }
+	if (node_end - node_begin == 1) { return node_begin; }
+
+	int middle = node_begin + (node_end - node_begin) / 2;
+	int time = FindFirstAboveInternal(2 * node, node_begin, middle, begin, end, threshold - addition_[node]);
+	if (time != -1) { return time; }
+	return FindFirstAboveInternal(2 * node + 1, middle, node_end, begin, end, threshold - addition_[node]);
+}
+
+int ResourceProfile::FindLastAboveInternal(int node, int node_begin, int node_end, int begin, int end, int threshold) const
+{
+	if (end <= node_begin || node_end <= begin || maximum_[node] <= threshold) { return -1; }
+	if (node_end - node_begin == 1) { return node_begin; }
+
+	int middle = node_begin + (node_end - node_begin) / 2;
+	int time = FindLastAboveInternal(2 * node + 1, middle, node_end, begin, end, threshold - addition_[node]);
+	if (time != -1) { return time; }
+	return FindLastAboveInternal(2 * node, node_begin, middle, begin, end, threshold - addition_[node]);
+}
+
+}
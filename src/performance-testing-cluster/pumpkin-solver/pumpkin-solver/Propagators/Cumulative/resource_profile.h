@@ -0,0 +1,37 @@
+#pragma once
+
+#include <vector>
+
+namespace Pumpkin
+{
+//resource profile over the times [0, num_times), stored as a segment tree
+//	the height of a time is the sum of the amounts added to ranges containing the time
+//	ranges are half-open [begin, end), parts of a range outside of [0, num_times) are ignored
+//	updates and queries take O(log num_times) time, the memory is O(num_times) regardless of the number of rectangles added
+class ResourceProfile
+{
+public:
+	ResourceProfile(int num_times);
+
+	void AddToRange(int begin, int end, int amount); //adds the amount to the height of each time in [begin, end)
+	void Clear(); //sets all heights to zero, O(num_times)
+
+	int GetHeight(int time) const;
+	int GetMaximum(int begin, int end) const; //maximum height in [begin, end), zero if the range is empty
+	int FindFirstAbove(int begin, int end, int threshold) const; //the earliest time in [begin, end) with a height above the threshold, -1 if there is no such time
+	int FindLastAbove(int begin, int end, int threshold) const; //the latest time in [begin, end) with a height above the threshold, -1 if there is no such time
+	int NumTimes() const;
+
+private:
+	//the node covers the times [node_begin, node_end), its children split the range in half
+	//	maximum_[node] is the maximum height of its range counting only the amounts added at the node and below
+	//	the amounts added to the whole range of a node are kept in addition_[node] and are never pushed down
+	void AddToRangeInternal(int node, int node_begin, int node_end, int begin, int end, int amount);
+	int GetMaximumInternal(int node, int node_begin, int node_end, int begin, int end) const;
+	int FindFirstAboveInternal(int node, int node_begin, int node_end, int begin, int end, int threshold) const;
+	int FindLastAboveInternal(int node, int node_begin, int node_end, int begin, int end, int threshold) const;
+
+	int num_times_;
+	std::vector<int> maximum_, addition_;
+};
+}
@@ -217,16 +217,17 @@ PropagationStatus LinearIntegerInequalityPropagator::InitialiseAtRootInternal()
 	pumpkin_assert_simple(state_->GetCurrentDecisionLevel() == 0, "Can only add the linear inequality propagator at the root node.");
 
 	//remove variables assigned at the root
+	//	the slack counts every variable at its root bound, for assigned variables this is their value so they can be dropped afterwards
 	int last_position = 0;
 	for (int i = 0; i < positive_terms_.size(); i++)
 	{
 		IntegerVariable variable = positive_terms_[i].term.variable;
+		int ub = state_->domain_manager_.GetUpperBound(variable);
+		root_slack_ += positive_terms_[i].term.weight * ub;
 		if (!state_->IsAssigned(variable))
 		{
-			int ub = state_->domain_manager_.GetUpperBound(positive_terms_[last_position].term.variable);
 			positive_terms_[last_position] = positive_terms_[i];
 			positive_terms_[last_position].root_bound = ub;
-			root_slack_ += positive_terms_[last_position].term.weight * ub;
 			last_position++;
 		}
 	}
@@ -236,19 +237,19 @@ PropagationStatus LinearIntegerInequalityPropagator::InitialiseAtRootInternal()
 	for (int i = 0; i < negative_terms_.size(); i++)
 	{
 		IntegerVariable variable = negative_terms_[i].term.variable;
+		int lb = state_->domain_manager_.GetLowerBound(variable);
+		root_slack_ += negative_terms_[i].term.weight * lb;
 		if (!state_->IsAssigned(variable))
 		{
-			int lb = state_->domain_manager_.GetLowerBound(negative_terms_[last_position].term.variable);
 			negative_terms_[last_position] = negative_terms_[i];
 			negative_terms_[last_position].root_bound = lb;
-			root_slack_ += negative_terms_[last_position].term.weight * lb;
 			last_position++;
 		}
 	}
 	negative_terms_.resize(last_position);	
 
+	//with a single variable left the constraint is a bound that is propagated at the root and cannot be violated afterwards
 	pumpkin_assert_permanent(root_slack_ >= 0, "For now we assume that the linear inequality cannot be violating at the root node.");
-	pumpkin_assert_simple(positive_terms_.size() + negative_terms_.size() > 1, "For now we expect the linear inequality propagator to have at least two variables, could be that most/all variables were preprocessed?");
 
 	return Propagate();
 }
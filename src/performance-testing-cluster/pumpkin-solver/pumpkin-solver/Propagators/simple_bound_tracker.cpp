@@ -45,8 +45,8 @@ void SimpleBoundTracker::UpdateDomain(IntegerVariable variable, DomainOperation
 	}
 	else if (operation.IsNotEqual())
 	{
-		//only do something if the value is in the domain - otherwise the value has already been removed through other means (say a lower bound operation took place right before this inequality)
-		if (domain.is_value_in_domain.ReadBit(right_hand_side))
+		//only do something if the value is in the domain - otherwise the value may lie outside of the root domain, or the value has already been removed through other means (say a lower bound operation took place right before this inequality)
+		if (right_hand_side >= 0 && right_hand_side < domain.is_value_in_domain.Size() && domain.is_value_in_domain.ReadBit(right_hand_side))
 		{
 			int old_lower_bound = GetLowerBound(variable);
 			int old_upper_bound = GetUpperBound(variable);
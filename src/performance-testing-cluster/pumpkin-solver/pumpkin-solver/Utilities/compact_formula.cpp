@@ -0,0 +1,159 @@
+#include "compact_formula.h"
+#include "pumpkin_assert.h"
+
+#include <stdlib.h>
+#include <algorithm>
+
+namespace Pumpkin
+{
+CompactFormula::CompactFormula():
+	num_Boolean_variables_(0)
+{
+}
+
+void CompactFormula::SetNumBooleanVariables(int64_t num_variables)
+{
+	if (num_variables > num_Boolean_variables_) { num_Boolean_variables_ = num_variables; }
+}
+
+void CompactFormula::AddHardClause(const std::vector<int32_t>& dimacs_literals)
+{
+	hard_clause_literals_.insert(hard_clause_literals_.end(), dimacs_literals.begin(), dimacs_literals.end());
+	hard_clause_literals_.push_back(0);
+}
+
+void CompactFormula::AddSoftClause(const std::vector<int32_t>& dimacs_literals, int64_t weight)
+{
+	soft_clause_literals_.insert(soft_clause_literals_.end(), dimacs_literals.begin(), dimacs_literals.end());
+	soft_clause_literals_.push_back(0);
+	soft_clause_weights_.push_back(weight);
+}
+
+void CompactFormula::AddLinearInequality(const std::vector<IntegerVariable>& variables, const std::vector<int64_t>& coefficients, int64_t right_hand_side)
+{
+	pumpkin_assert_simple(variables.size() == coefficients.size(), "Sanity check.");
+	linear_variables_.insert(linear_variables_.end(), variables.begin(), variables.end());
+	linear_coefficients_.insert(linear_coefficients_.end(), coefficients.begin(), coefficients.end());
+	linear_term_ends_.push_back(linear_variables_.size());
+	linear_right_hand_sides_.push_back(right_hand_side);
+}
+
+void CompactFormula::AddCumulative(const std::vector<IntegerVariable>& start_times, const std::vector<int>& durations, const std::vector<int>& resource_consumptions, int capacity)
+{
+	std::vector<IntegerVariable> null_variables(start_times.size());
+	AddPreemptiveCumulative(null_variables, start_times, null_variables, durations, resource_consumptions, capacity);
+}
+
+void CompactFormula::AddPreemptiveCumulative(const std::vector<IntegerVariable>& presences, const std::vector<IntegerVariable>& start_times, const std::vector<IntegerVariable>& lengths, const std::vector<int>& length_offsets, const std::vector<int>& resource_consumptions, int capacity)
+{
+	cumulatives_.push_back(Cumulative{ presences, start_times, lengths, length_offsets, resource_consumptions, capacity });
+}
+
+void CompactFormula::AddObjectiveTerm(IntegerVariable variable, int64_t weight)
+{
+	objective_variables_.push_back(variable);
+	objective_weights_.push_back(weight);
+}
+
+int64_t CompactFormula::NumBooleanVariables() const
+{
+	return num_Boolean_variables_;
+}
+
+bool CompactFormula::IsEmpty() const
+{
+	return hard_clause_literals_.empty() && soft_clause_literals_.empty() && linear_right_hand_sides_.empty() && cumulatives_.empty() && objective_variables_.empty();
+}
+
+bool CompactFormula::IsSatisfyingAssignment(const BooleanAssignmentVector& solution) const
+{
+	bool clause_satisfied = false;
+	for (int32_t literal : hard_clause_literals_)
+	{
+		if (literal == 0) //end of the clause
+		{
+			if (!clause_satisfied) { return false; }
+			clause_satisfied = false;
+		}
+		else if (!clause_satisfied)
+		{
+			int32_t var_index = abs(literal);
+			clause_satisfied = (solution[var_index] == (literal > 0));
+		}
+	}
+	return true;
+}
+
+int64_t CompactFormula::ComputeCost(const BooleanAssignmentVector& solution) const
+{
+	int64_t cost = 0;
+	size_t clause_index = 0;
+	bool clause_satisfied = false;
+	for (int32_t literal : soft_clause_literals_)
+	{
+		if (literal == 0) //end of the clause
+		{
+			cost += (!clause_satisfied) * soft_clause_weights_[clause_index];
+			clause_index++;
+			clause_satisfied = false;
+		}
+		else if (!clause_satisfied)
+		{
+			int32_t var_index = abs(literal);
+			clause_satisfied = (solution[var_index] == (literal > 0));
+		}
+	}
+	pumpkin_assert_simple(clause_index == soft_clause_weights_.size(), "Sanity check.");
+	return cost;
+}
+
+bool CompactFormula::IsSatisfyingAssignment(const IntegerAssignmentVector& solution) const
+{
+	size_t term_index = 0;
+	for (size_t i = 0; i < linear_right_hand_sides_.size(); i++)
+	{
+		int64_t left_hand_side = 0;
+		for (; term_index < linear_term_ends_[i]; term_index++)
+		{
+			left_hand_side += linear_coefficients_[term_index] * solution[linear_variables_[term_index]];
+		}
+		if (left_hand_side < linear_right_hand_sides_[i]) { return false; }
+	}
+
+	//the resource usage only changes at the start and end of a segment, ends are processed before starts at the same time
+	std::vector<std::pair<int, int> > usage_changes; //time, change in resource usage
+	for (const Cumulative& cumulative : cumulatives_)
+	{
+		usage_changes.clear();
+		for (size_t i = 0; i < cumulative.start_times.size(); i++)
+		{
+			if (!cumulative.presences[i].IsNull() && solution[cumulative.presences[i]] == 0) { continue; }
+
+			int start_time = solution[cumulative.start_times[i]];
+			int length = cumulative.length_offsets[i] + (cumulative.lengths[i].IsNull() ? 0 : solution[cumulative.lengths[i]]);
+			usage_changes.push_back(std::make_pair(start_time, cumulative.resource_consumptions[i]));
+			usage_changes.push_back(std::make_pair(start_time + length, -cumulative.resource_consumptions[i]));
+		}
+		std::sort(usage_changes.begin(), usage_changes.end());
+
+		int64_t usage = 0;
+		for (const std::pair<int, int>& usage_change : usage_changes)
+		{
+			usage += usage_change.second;
+			if (usage > cumulative.capacity) { return false; }
+		}
+	}
+	return true;
+}
+
+int64_t CompactFormula::ComputeCost(const IntegerAssignmentVector& solution) const
+{
+	int64_t cost = 0;
+	for (size_t i = 0; i < objective_variables_.size(); i++)
+	{
+		cost += objective_weights_[i] * solution[objective_variables_[i]];
+	}
+	return cost;
+}
+
+} //end Pumpkin namespace
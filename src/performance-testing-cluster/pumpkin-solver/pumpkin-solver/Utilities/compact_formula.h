@@ -0,0 +1,60 @@
+#pragma once
+
+#include "boolean_assignment_vector.h"
+#include "integer_assignment_vector.h"
+#include "integer_variable.h"
+
+#include <vector>
+#include <stdint.h>
+
+namespace Pumpkin
+{
+//Keeps a copy of the input formula that is only used to verify solutions, so that the input file does not need to be parsed a second time
+//	clauses are stored back to back as zero-terminated DIMACS literals, which avoids allocating a vector per clause as done in ProblemSpecification
+class CompactFormula
+{
+public:
+	CompactFormula();
+
+	void SetNumBooleanVariables(int64_t num_variables);
+	void AddHardClause(const std::vector<int32_t>& dimacs_literals);
+	void AddSoftClause(const std::vector<int32_t>& dimacs_literals, int64_t weight);
+	//integer constraints and objective terms of models that are handled by propagators, with the same meaning as in ConstraintOptimisationSolver
+	//	a cumulative constraint is kept as a preemptive one whose segments are mandatory and have their duration as fixed length
+	void AddLinearInequality(const std::vector<IntegerVariable>& variables, const std::vector<int64_t>& coefficients, int64_t right_hand_side);
+	void AddCumulative(const std::vector<IntegerVariable>& start_times, const std::vector<int>& durations, const std::vector<int>& resource_consumptions, int capacity);
+	void AddPreemptiveCumulative(const std::vector<IntegerVariable>& presences, const std::vector<IntegerVariable>& start_times, const std::vector<IntegerVariable>& lengths, const std::vector<int>& length_offsets, const std::vector<int>& resource_consumptions, int capacity);
+	void AddObjectiveTerm(IntegerVariable variable, int64_t weight);
+
+	int64_t NumBooleanVariables() const;
+	bool IsEmpty() const;
+	bool IsSatisfyingAssignment(const BooleanAssignmentVector& solution) const; //solution[i] is the truth assignment for the variable with index i
+	int64_t ComputeCost(const BooleanAssignmentVector& solution) const;
+	bool IsSatisfyingAssignment(const IntegerAssignmentVector& solution) const; //checks the integer constraints only
+	int64_t ComputeCost(const IntegerAssignmentVector& solution) const; //cost of the integer objective terms only
+
+private:
+	int64_t num_Boolean_variables_;
+	std::vector<int32_t> hard_clause_literals_;
+	std::vector<int32_t> soft_clause_literals_;
+	std::vector<int64_t> soft_clause_weights_;
+
+	//the terms of the linear inequalities are stored back to back, inequality i has the terms [linear_term_ends_[i - 1], linear_term_ends_[i])
+	std::vector<IntegerVariable> linear_variables_;
+	std::vector<int64_t> linear_coefficients_;
+	std::vector<size_t> linear_term_ends_;
+	std::vector<int64_t> linear_right_hand_sides_;
+
+	struct Cumulative
+	{
+		std::vector<IntegerVariable> presences, start_times, lengths;
+		std::vector<int> length_offsets, resource_consumptions;
+		int capacity;
+	};
+	std::vector<Cumulative> cumulatives_;
+
+	std::vector<IntegerVariable> objective_variables_;
+	std::vector<int64_t> objective_weights_;
+};
+
+} //end Pumpkin namespace
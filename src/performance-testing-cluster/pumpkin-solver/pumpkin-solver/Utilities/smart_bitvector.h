@@ -158,7 +158,7 @@ inline void SmartBitvector::Resize(int new_size)
 
 		//allocate memory and initialise values
 		bool* new_memory = new bool[new_size];
-		for (int i = 0; i < old_size; i++) { new_memory[i] = ReadBit(i); }
+		for (int i = 0; i < old_size && i < new_size; i++) { new_memory[i] = ReadBit(i); }
 		for (int i = old_size; i < new_size; i++) { new_memory[i] = false; }
 		//set internal data structures		
 		delete[] data_.pointer_to_bitvector; //remember to delete the previously allocated memory
@@ -175,7 +175,7 @@ inline void SmartBitvector::Resize(int new_size)
 			//set the bit if necessary, otherwise do nothing since the default value is zero
 			if (data_.pointer_to_bitvector[i])
 			{
-				new_inlined_bitvector |= (1 << i);
+				new_inlined_bitvector |= (uint64_t(1) << i);
 			}			
 		}
 		//set internal data structures
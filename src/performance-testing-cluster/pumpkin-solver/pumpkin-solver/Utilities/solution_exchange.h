@@ -0,0 +1,40 @@
+#pragma once
+
+#include "integer_assignment_vector.h"
+
+#include <vector>
+#include <stdint.h>
+
+namespace Pumpkin
+{
+//exchanges solutions with a search that runs concurrently with the solver, e.g., a heuristic working on the same problem
+//	solutions are given in terms of the input variables using the DIMACS numbering
+//	the methods are called from the thread of the solver, implementations need to synchronise with the other search themselves
+class SolutionExchange
+{
+public:
+	virtual ~SolutionExchange() {}
+
+	//polled by the linear search at every restart, returning true interrupts the search to import the external solution
+	virtual bool HasExternalSolution() = 0;
+	//returns the DIMACS literals of the external solution; a partial assignment is completed by the solver, an empty vector means there is no solution anymore
+	virtual std::vector<int32_t> TakeExternalSolution() = 0;
+	//called with every solution that improves the upper bound, including accepted external solutions
+	//	input_variable_values[i] is the truth value of the i-th input variable (index zero is not used), the cost and lower bound refer to the original objective
+	virtual void ReportSolution(const std::vector<bool>& input_variable_values, int64_t cost, int64_t lower_bound) = 0;
+
+	//reports a solution of the solver, where the input variables are the integer variables 2..num_input_variables+1
+	void ReportSolverSolution(const IntegerAssignmentVector& solution, int64_t num_input_variables, int64_t cost, int64_t lower_bound);
+};
+
+inline void SolutionExchange::ReportSolverSolution(const IntegerAssignmentVector& solution, int64_t num_input_variables, int64_t cost, int64_t lower_bound)
+{
+	std::vector<bool> input_variable_values(num_input_variables + 1, false);
+	for (int i = 1; i <= num_input_variables; i++)
+	{
+		input_variable_values[i] = (solution[IntegerVariable(i + 1)] == 1); //plus one since the solver reserves indicies 0 and 1 for special purpose
+	}
+	ReportSolution(input_variable_values, cost, lower_bound);
+}
+
+} //end Pumpkin namespace
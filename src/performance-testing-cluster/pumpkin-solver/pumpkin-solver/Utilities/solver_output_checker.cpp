@@ -49,4 +49,37 @@ bool SolverOutputChecker::CheckSolutionCorrectness(ProblemSpecification& problem
 	}
 	return true;
 }
+
+bool SolverOutputChecker::CheckSolutionCorrectness(const CompactFormula& formula, SolverOutput& output, bool verbose)
+{
+	if (output.HasSolution())
+	{
+		BooleanAssignmentVector boolean_assignments(formula.NumBooleanVariables(), false);
+		for (int i = 1; i <= formula.NumBooleanVariables(); i++)
+		{
+			int truth_value = output.solution[IntegerVariable(i + 1)]; //+1 since the solver reserves indicies 0 and 1 for special purpose
+			pumpkin_assert_permanent(truth_value == 0 || truth_value == 1, "Assignment to Boolean variable must be binary.");
+			boolean_assignments[i] = truth_value;
+		}
+
+		if (formula.IsSatisfyingAssignment(boolean_assignments) == false || formula.IsSatisfyingAssignment(output.solution) == false)
+		{
+			// if (verbose) std::cout << "Solution not OK: does not satisfy hard constraints!\n";
+			return false;
+		}
+
+		int64_t computed_cost = formula.ComputeCost(boolean_assignments) + formula.ComputeCost(output.solution);
+		if (computed_cost > output.cost)
+		{
+			if (verbose)
+			{
+				// std::cout << "Solution not OK: reported cost is lower than the actual cost!\n";
+				// std::cout << "\tReported cost: " << output.cost << "\n";
+				// std::cout << "\tRecomputed cost: " << computed_cost << "\n";
+			}
+			return false;
+		}
+	}
+	return true;
+}
 }
\ No newline at end of file
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "problem_specification.h"
+#include "compact_formula.h"
 #include "solver_output.h"
 
 #include <iostream>
@@ -11,6 +12,9 @@ class SolverOutputChecker
 {
 public:
 	static bool CheckSolutionCorrectness(ProblemSpecification& problem_specification, SolverOutput& output, bool verbose);
+	//same checks as above, but against the copy of the formula retained by the solver instead of a reparsed file
+	//	the integer constraints and objective terms retained with the formula are checked as well
+	static bool CheckSolutionCorrectness(const CompactFormula& formula, SolverOutput& output, bool verbose);
 };
 
 }
\ No newline at end of file
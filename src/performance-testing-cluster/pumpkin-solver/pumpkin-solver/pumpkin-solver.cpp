@@ -4,6 +4,7 @@ Pumpkin::ConstraintOptimisationSolver* g_solver;
 time_t g_start_solve;
 clock_t g_start_clock;
 bool g_print_sol;
+std::vector<std::string> g_solver_arguments; // "-name value" pairs applied on top of the default parameters
 
 std::string MainGetStatisticsAsString()
 {
@@ -63,34 +64,31 @@ static void SIGINT_exit(int signum)
 	exit(1);
 }
 
-int solve(std::string wncf_filename, bool& optimum_found)
+static Pumpkin::ParameterHandler create_solver_parameters()
 {
-	signal(SIGINT, SIGINT_exit);
-	signal(SIGTERM, SIGINT_exit);
-	g_start_solve = time(0);
-	g_start_clock = clock();
-
 	Pumpkin::ParameterHandler parameters = Pumpkin::ConstraintOptimisationSolver::CreateParameterHandler();
 
 	g_print_sol = parameters.GetBooleanParameter("print-solution");
 
-	std::string file = "";
-
 	g_print_sol = false;
-	parameters.SetStringParameter("file", wncf_filename);
 
 	//parameters.SetIntegerParameter("time", cpu_time_deadline);
 
-	Pumpkin::ConstraintOptimisationSolver::CheckCorrectnessOfParameterHandler(parameters);
-
-	file = parameters.GetStringParameter("file");
-
-	// std::cout << "c File: " << file << std::endl;
+	// The first argument is skipped as the program name
+	std::vector<char*> arguments{ nullptr };
+	for (std::string& argument : g_solver_arguments)
+	{
+		arguments.push_back(&argument[0]);
+	}
+	parameters.ParseCommandLineArguments(arguments.size(), arguments.data());
 
-	Pumpkin::ProblemSpecification* problem_specification;
+	return parameters;
+}
 
-	Pumpkin::ConstraintOptimisationSolver solver(parameters);
-	solver.ReadDIMACSFile(parameters.GetStringParameter("file"));
+// Runs the solver on a formula that has already been loaded and reports the cost
+// The solution is verified against the formula retained by the solver, or by reparsing the file with the verify-by-reparsing debug parameter
+static int solve_loaded_formula(Pumpkin::ConstraintOptimisationSolver& solver, Pumpkin::ParameterHandler& parameters, std::string file, bool& optimum_found)
+{
 	g_solver = &solver;
 
 	int64_t time_core_guided = parameters.GetIntegerParameter("time-core-guided");
@@ -101,23 +99,32 @@ int solve(std::string wncf_filename, bool& optimum_found)
 	// if (solver_output.timeout_happened == false) { std::cout << "c optimal\n"; }
 	// else { std::cout << "c timeout\n"; }
 
-	std::string file_type = Pumpkin::ProblemSpecification::GetFileType(file);
-	if (file_type == "wcnf")
-	{
-		problem_specification = new Pumpkin::ProblemSpecification(Pumpkin::ProblemSpecification::ReadMaxSATFormula(file));
-	}
-	else if (file_type == "cnf")
+	Pumpkin::ProblemSpecification* problem_specification = NULL;
+
+	if (parameters.GetBooleanParameter("verify-by-reparsing") && file != "")
 	{
-		problem_specification = new Pumpkin::ProblemSpecification(Pumpkin::ProblemSpecification::ReadSATFormula(file));
+		std::string file_type = Pumpkin::ProblemSpecification::GetFileType(file);
+		if (file_type == "wcnf")
+		{
+			problem_specification = new Pumpkin::ProblemSpecification(Pumpkin::ProblemSpecification::ReadMaxSATFormula(file));
+		}
+		else if (file_type == "cnf")
+		{
+			problem_specification = new Pumpkin::ProblemSpecification(Pumpkin::ProblemSpecification::ReadSATFormula(file));
+		}
+		else
+		{
+			std::cout << "Unknown file format! File type was: " << file_type << ", but should be either wcnf or cnf\n";
+			std::cout << "I think the problem specification reader does not work with compressed files, so that may be the issue.\n";
+			std::cout << "File: " << file << "\n";
+			return 1;
+		}
+		runtime_assert(Pumpkin::SolverOutputChecker::CheckSolutionCorrectness(*problem_specification, solver_output, true));
 	}
-	else
+	else if (parameters.GetBooleanParameter("retain-input-formula"))
 	{
-		std::cout << "Unknown file format! File type was: " << file_type << ", but should be either wcnf or cnf\n";
-		std::cout << "I think the problem specification reader does not work with compressed files, so that may be the issue.\n";
-		std::cout << "File: " << file << "\n";
-		return 1;
+		runtime_assert(Pumpkin::SolverOutputChecker::CheckSolutionCorrectness(solver.GetRetainedInputFormula(), solver_output, true));
 	}
-	runtime_assert(Pumpkin::SolverOutputChecker::CheckSolutionCorrectness(*problem_specification, solver_output, true));
 
 	if (parameters.GetStringParameter("output-file") != "")
 	{
@@ -129,7 +136,7 @@ int solve(std::string wncf_filename, bool& optimum_found)
 		else if (solver_output.HasSolution())
 		{
 			std::cout << solver_output.cost << "\n";
-			for (int i = 1; i <= problem_specification->NumBooleanVariables(); i++)
+			for (int i = 1; i <= solver.num_boolean_variables_; i++)
 			{
 				int truth_value = solver_output.solution[Pumpkin::IntegerVariable(i + 1)]; //+1 since the solver reserves indicies 0 and 1 for special purpose
 				pumpkin_assert_permanent(truth_value == 0 || truth_value == 1, "Assignment to Boolean variable must be binary.");
@@ -167,3 +174,50 @@ int solve(std::string wncf_filename, bool& optimum_found)
 
 	return solver_output.cost;
 }
+
+int solve(std::string wncf_filename, bool& optimum_found)
+{
+	signal(SIGINT, SIGINT_exit);
+	signal(SIGTERM, SIGINT_exit);
+	g_start_solve = time(0);
+	g_start_clock = clock();
+
+	Pumpkin::ParameterHandler parameters = create_solver_parameters();
+	parameters.SetStringParameter("file", wncf_filename);
+
+	Pumpkin::ConstraintOptimisationSolver::CheckCorrectnessOfParameterHandler(parameters);
+
+	std::string file = parameters.GetStringParameter("file");
+
+	// std::cout << "c File: " << file << std::endl;
+
+	Pumpkin::ConstraintOptimisationSolver solver(parameters);
+	solver.ReadDIMACSFile(file);
+
+	return solve_loaded_formula(solver, parameters, file, optimum_found);
+}
+
+void set_solver_parameter(std::string name, std::string value)
+{
+	g_solver_arguments.push_back("-" + name);
+	g_solver_arguments.push_back(value);
+}
+
+int solve(std::function<void(Pumpkin::ConstraintOptimisationSolver&)> load_formula, bool& optimum_found)
+{
+	signal(SIGINT, SIGINT_exit);
+	signal(SIGTERM, SIGINT_exit);
+	g_start_solve = time(0);
+	g_start_clock = clock();
+
+	Pumpkin::ParameterHandler parameters = create_solver_parameters();
+
+	Pumpkin::ConstraintOptimisationSolver::CheckCorrectnessOfParameterHandler(parameters);
+
+	Pumpkin::ConstraintOptimisationSolver solver(parameters);
+	g_solver = &solver;
+	load_formula(solver);
+	solver.FinishProgrammaticInput();
+
+	return solve_loaded_formula(solver, parameters, "", optimum_found);
+}
@@ -10,5 +10,10 @@
 #include <cstdlib>
 #include <signal.h>
 #include <string>
+#include <functional>
 
-int solve(std::string wncf_filename, bool& optimum_found);
\ No newline at end of file
+int solve(std::string wncf_filename, bool& optimum_found);
+// Solves the formula that load_formula adds to the solver through its clause API, no file is read
+int solve(std::function<void(Pumpkin::ConstraintOptimisationSolver&)> load_formula, bool& optimum_found);
+// Sets a solver parameter for every following solve, the value is parsed as it would be on the command line of Pumpkin
+void set_solver_parameter(std::string name, std::string value);
\ No newline at end of file